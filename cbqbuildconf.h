@@ -56,6 +56,59 @@
 /* Disable stdint.h type declarations for CBQArg_t */
 // #define NO_FIX_ARGTYPES
 
+/* Number of arguments which are stored right in the call container (without heap allocation).
+ * Calls with more arguments than that spill into a separate heap buffer.
+ * Must be in range of minimal and maximal argument capacities (2..20), by default is 5.
+ */
+// #define CBQ_INLINE_ARGS 5
+
+/* Keep queue capacity as power of two (rounded up on init and capacity changes, limit is rounded down).
+ * Read and store ids become free-running counters, which are wrapped into cells by mask,
+ * so there are no divisions and index resets on push, exec and other queue loops.
+ */
+// #define CBQ_POW2_CAPACITY
+
+/* Store queue containers in fixed-size blocks (chunks) instead of one array.
+ * Capacity grows by inserting new blocks at the store point and shrinks by releasing free blocks,
+ * so containers are never reordered and push has no latency spikes of big queue reallocation.
+ * Capacity and limit are rounded up to whole blocks. Block capacity (power of two, 64 by default)
+ * can be set with CBQ_CHUNK_CAPACITY. Cannot be used with CBQ_POW2_CAPACITY.
+ */
+// #define CBQ_CHUNKED_STORAGE
+// #define CBQ_CHUNK_CAPACITY 64
+
+/* Keep released spilled args buffers in per-thread pool by capacity classes (MIN_CAP_ARGS..MAX_CAP_ARGS)
+ * and take them from it before heap allocation. Used by queues with default allocator only.
+ * Number of buffers in each class is limited by CBQ_ARGS_POOL_CLASS_LIMIT (32 by default).
+ */
+// #define CBQ_ARGS_POOL
+// #define CBQ_ARGS_POOL_CLASS_LIMIT 32
+
+/* Lazy init of containers: storage of queue is only allocated zeroed (calloc, or allocZeroed of allocator)
+ * and containers get their args storage on first push into them, so init and capacity increment
+ * of big queues do not touch all containers memory.
+ */
+// #define CBQ_LAZY_INIT
+
+/* Number of exec attempts of waiting exec methods (ExecWait of concurrent queues)
+ * before consumer sleeps on futex (short sleeps without it), 100 by default.
+ */
+// #define CBQ_WAIT_SPIN_COUNT 100
+
+/* Number of calls which CBQ_ExecFor runs between reads of monotonic clock, 16 by default.
+ * Bigger step makes clock reads cheaper, but budget may be exceeded by longer tail of calls.
+ */
+// #define CBQ_EXEC_FOR_CHECK_STEP 16
+
+/* Timer methods of SetTimeout, timer wheel and auto shrink interval:
+ * 1 - clock() (processor time of process, delays are stretched while process is idle or blocked),
+ * 2 - monotonic clock (CLOCK_MONOTONIC), ns resolution, default,
+ * 3 - cached coarse monotonic clock (CLOCK_MONOTONIC_COARSE where it exists): exec methods refresh
+ *     thread local time once per call or batch and timer checks only read it. Checks are cheaper,
+ *     but timeout may fire later by resolution of coarse clock (few ms) and length of batch.
+ */
+// #define CBQ_TIMER_METHODS 2
+
 /* Enable to generate the identifier of the compiled library.
  * Possibly unsafe, because it stores embedded information about the enabled flags.
  */
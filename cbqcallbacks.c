@@ -1,44 +1,173 @@
 #include "cbqcallbacks.h"
+#include "cbqtimer.h"
+#include "cbqcontainer.h"
 
 static int CBQ_setTimeoutFrame__(int, CBQArg_t*);
+static int CBQ_setIntervalFrame__(int, CBQArg_t*);
+static int CBQ_pushTimerFrame__(CBQueue_t*, CBQTicks_t, CBQTicks_t, int, CBQueue_t*, QCallback, unsigned int, const CBQArg_t*);
+static void CBQ_setTimerHandle__(CBQHandle_t*, CBQueue_t*, const CBQTimerHandle_t*);
 
-int CBQ_SetTimeout(CBQueue_t* queue, CBQTicks_t delay, const int isSec,
+int CBQ_SetTimeout(CBQueue_t* queue, clock_t delay, const int isSec,
     CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams)
 {
+    /* passed delay is pushed at once */
+    if (delay < 0)
+        delay = 0;
+
+    if (isSec)
+        return CBQ_SetTimeoutNs(queue, (unsigned long long) delay * 1000000000ULL, targetQueue, func, vParamc, vParams, NULL);
+    else
+        return CBQ_SetTimeoutNs(queue, (unsigned long long) delay * (1000000000ULL / (unsigned long long) CLOCKS_PER_SEC),
+            targetQueue, func, vParamc, vParams, NULL);
+}
+
+int CBQ_SetTimeoutNs(CBQueue_t* queue, unsigned long long delayNs,
+    CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams, CBQHandle_t* handle)
+{
+    CBQTimerHandle_t timer;
     CBQTicks_t targetTime;
+    int errSt;
 
     BASE_ERR_CHECK(queue);
     if (targetQueue != queue) {
         BASE_ERR_CHECK(targetQueue);
     }
 
-    if (isSec)
-        targetTime = CBQ_CURTICKS() + (CBQTicks_t)(delay * CBQ_TIC_P_SEC);
-    else
-        targetTime = CBQ_CURTICKS() + (CBQTicks_t)delay;
+    /* attached heap or wheel keeps call until it is due */
+    if (queue->deadlines != NULL || queue->timers != NULL) {
+        if (queue->deadlines != NULL)
+            errSt = CBQ_DeadlineAdd(queue->deadlines, delayNs, targetQueue, func, vParamc, vParams, &timer);
+        else
+            errSt = CBQ_TimerAdd(queue->timers, delayNs, targetQueue, func, vParamc, vParams, &timer);
+
+        if (!errSt)
+            CBQ_setTimerHandle__(handle, queue, &timer);
+        return errSt;
+    }
 
-    return CBQ_Push(queue, CBQ_setTimeoutFrame__, vParamc, vParams, ST_ARG_C,
-        (CBQArg_t) {.qVar = queue},
-        (CBQArg_t) {.liVar = targetTime},
-        (CBQArg_t) {.qVar = targetQueue},
-        (CBQArg_t) {.fVar = func});
+    if (handle != NULL)
+        return CBQ_ERR_TIMERS_NOT_ATTACHED;
+
+    targetTime = CBQ_FRESHTICKS() + CBQ_NS_TO_TICKS(delayNs);
+
+    return CBQ_pushTimerFrame__(queue, targetTime, 0, 0, targetQueue, func, vParams != NULL? vParamc : 0, vParams);
+}
+
+int CBQ_SetInterval(CBQueue_t* queue, unsigned long long periodNs, int policy,
+    CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams, CBQHandle_t* handle)
+{
+    CBQTimerHandle_t timer;
+    CBQTicks_t period;
+    int errSt;
+
+    BASE_ERR_CHECK(queue);
+    if (targetQueue != queue) {
+        BASE_ERR_CHECK(targetQueue);
+    }
+
+    /* attached heap or wheel keeps node with args for all calls */
+    if (queue->deadlines != NULL || queue->timers != NULL) {
+        if (queue->deadlines != NULL)
+            errSt = CBQ_DeadlineAddPeriodic(queue->deadlines, periodNs, policy, targetQueue, func, vParamc, vParams, &timer);
+        else
+            errSt = CBQ_TimerAddPeriodic(queue->timers, periodNs, policy, targetQueue, func, vParamc, vParams, &timer);
+
+        if (!errSt)
+            CBQ_setTimerHandle__(handle, queue, &timer);
+        return errSt;
+    }
+
+    if (handle != NULL)
+        return CBQ_ERR_TIMERS_NOT_ATTACHED;
+
+    if (!periodNs || (policy != CBQ_IP_SKIP && policy != CBQ_IP_CATCH_UP))
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    period = CBQ_NS_TO_TICKS(periodNs);
+    if (period < 1)
+        period = 1;
+
+    return CBQ_pushTimerFrame__(queue, CBQ_FRESHTICKS() + period, period, policy,
+        targetQueue, func, vParams != NULL? vParamc : 0, vParams);
+}
+
+/* Handle of timeout is canceled by heap or wheel of queue */
+static void CBQ_setTimerHandle__(CBQHandle_t* handle, CBQueue_t* queue, const CBQTimerHandle_t* timer)
+{
+    if (handle != NULL) {
+        handle->queue = queue;
+        handle->seq = 0;
+        handle->gen = timer->gen;
+        handle->timer = timer->timer;
+    }
+}
+
+/* Frame args are written into reserved call, because static params of CBQ_Push
+ * are read as array of stack (it is not so on ABIs which pass variadic args by registers).
+ * Frame with period is interval frame, it has period and policy after timeout args.
+ */
+static int CBQ_pushTimerFrame__(CBQueue_t* queue, CBQTicks_t targetTime, CBQTicks_t period, int policy,
+    CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, const CBQArg_t* vParams)
+{
+    const unsigned int frameArgc = period? IN_ARG_C : ST_ARG_C;
+    CBQArg_t* args;
+    int errSt;
+
+    errSt = CBQ_PushReserve(queue, period? CBQ_setIntervalFrame__ : CBQ_setTimeoutFrame__, frameArgc + vParamc, &args);
+    if (errSt)
+        return errSt;
+
+    args[ST_QUEUE].qVar = queue;
+    args[ST_DELAY].lliVar = targetTime;
+    args[ST_TRG_QUEUE].qVar = targetQueue;
+    args[ST_FUNC].fVar = func;
+
+    if (period) {
+        args[IN_PERIOD].lliVar = period;
+        args[IN_POLICY].iVar = policy;
+    }
+
+    if (vParamc)
+        CBQ_copyArgs__(vParams, args + frameArgc, vParamc);
+
+    return CBQ_PushCommit(queue);
 }
 
 static int CBQ_setTimeoutFrame__(int argc, CBQArg_t* args)
 {
-    if (CBQ_CURTICKS() >= (CBQTicks_t) args[ST_DELAY].liVar) {
+    if (CBQ_CURTICKS() >= (CBQTicks_t) args[ST_DELAY].lliVar) {
 
         if (args[ST_QUEUE].qVar == args[ST_TRG_QUEUE].qVar)
             return args[ST_FUNC].fVar(argc - ST_ARG_C, args + ST_ARG_C);
         else
             return CBQ_Push(args[ST_TRG_QUEUE].qVar, args[ST_FUNC].fVar,
-                        argc - ST_ARG_C, args + ST_ARG_C, 0, CBQ_NO_STPARAMS);
+                        argc - ST_ARG_C, (argc - ST_ARG_C)? args + ST_ARG_C : NULL, 0, CBQ_NO_STPARAMS);
 
     } else
-        return CBQ_Push(args[ST_QUEUE].qVar, CBQ_setTimeoutFrame__,
-            argc - ST_ARG_C, (argc - ST_ARG_C)? args + ST_ARG_C : NULL, ST_ARG_C,
-            (CBQArg_t) {.qVar = args[ST_QUEUE].qVar},
-            (CBQArg_t) {.liVar = args[ST_DELAY].liVar},
-            (CBQArg_t) {.qVar = args[ST_TRG_QUEUE].qVar},
-            (CBQArg_t) {.fVar = args[ST_FUNC].fVar});
+        return CBQ_pushTimerFrame__(args[ST_QUEUE].qVar, (CBQTicks_t) args[ST_DELAY].lliVar, 0, 0,
+            args[ST_TRG_QUEUE].qVar, args[ST_FUNC].fVar, argc - ST_ARG_C, args + ST_ARG_C);
+}
+
+/* Interval frame is always pushed again, due call is done (or pushed into target queue) before it */
+static int CBQ_setIntervalFrame__(int argc, CBQArg_t* args)
+{
+    const CBQTicks_t now = CBQ_CURTICKS();
+    CBQTicks_t deadline = (CBQTicks_t) args[ST_DELAY].lliVar;
+    int callSt = 0, errSt;
+
+    if (now >= deadline) {
+
+        if (args[ST_QUEUE].qVar == args[ST_TRG_QUEUE].qVar)
+            callSt = args[ST_FUNC].fVar(argc - IN_ARG_C, args + IN_ARG_C);
+        else
+            callSt = CBQ_Push(args[ST_TRG_QUEUE].qVar, args[ST_FUNC].fVar,
+                        argc - IN_ARG_C, (argc - IN_ARG_C)? args + IN_ARG_C : NULL, 0, CBQ_NO_STPARAMS);
+
+        deadline = CBQ_NEXT_DEADLINE(deadline, (CBQTicks_t) args[IN_PERIOD].lliVar, args[IN_POLICY].iVar, now);
+    }
+
+    errSt = CBQ_pushTimerFrame__(args[ST_QUEUE].qVar, deadline, (CBQTicks_t) args[IN_PERIOD].lliVar, args[IN_POLICY].iVar,
+        args[ST_TRG_QUEUE].qVar, args[ST_FUNC].fVar, argc - IN_ARG_C, args + IN_ARG_C);
+
+    return errSt? errSt : callSt;
 }
@@ -6,7 +6,11 @@
 #include "cbqlocal.h"
 
 /* push CB after delay, like JS func */
-int CBQ_SetTimeout(CBQueue_t* queue, CBQTicks_t delay, const int isSec,
+int CBQ_SetTimeout(CBQueue_t* queue, clock_t delay, const int isSec,
     CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams);
+int CBQ_SetTimeoutNs(CBQueue_t* queue, unsigned long long delayNs,
+    CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams, CBQHandle_t* handle);
+int CBQ_SetInterval(CBQueue_t* queue, unsigned long long periodNs, int policy,
+    CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams, CBQHandle_t* handle);
 
 #endif // CBQCALLBACKS_H
@@ -4,6 +4,16 @@
 #include "cbqcontainer.h"
 
 size_t CBQ_getSizeByIndexes__(const CBQueue_t* trustedQueue)
+{
+    #ifdef CBQ_POW2_CAPACITY
+    return trustedQueue->sId - trustedQueue->rId;
+    #else
+    return CBQ_getSizeByCells__(trustedQueue);
+    #endif // CBQ_POW2_CAPACITY
+}
+
+/* Size by cell indexes of ids and status (capacity changing methods work with cells) */
+size_t CBQ_getSizeByCells__(const CBQueue_t* trustedQueue)
 {
     if (trustedQueue->rId < trustedQueue->sId)
         return trustedQueue->sId - trustedQueue->rId;
@@ -13,7 +23,326 @@ size_t CBQ_getSizeByIndexes__(const CBQueue_t* trustedQueue)
         return 0;   // empty trustedQueue
 }
 
+/* (also used for capacity of concurrent queues) */
+size_t CBQ_roundUpPow2__(size_t value)
+{
+    size_t pow2 = 1;
+
+    while (pow2 < value)
+        pow2 <<= 1;
+
+    return pow2;
+}
+
+size_t CBQ_roundDownPow2__(size_t value)
+{
+    size_t pow2 = 1;
+
+    while (pow2 <= value >> 1)
+        pow2 <<= 1;
+
+    return pow2;
+}
+
+#ifdef CBQ_POW2_CAPACITY
+
+/* Free-running ids are wrapped into cells before capacity changing
+ * and become counters again after it (with the same cell of read id)
+ */
+static void CBQ_idsToCells__(CBQueue_t* trustedQueue)
+{
+    trustedQueue->rId = CBQ_CELL_ID(trustedQueue, trustedQueue->rId);
+    trustedQueue->sId = CBQ_CELL_ID(trustedQueue, trustedQueue->sId);
+}
+
+static void CBQ_cellsToIds__(CBQueue_t* trustedQueue)
+{
+    trustedQueue->sId = trustedQueue->rId + CBQ_getSizeByCells__(trustedQueue);
+}
+#endif // CBQ_POW2_CAPACITY
+
+#ifdef CBQ_CHUNKED_STORAGE
+size_t CBQ_roundUpChunks__(size_t value)
+{
+    return (value + CBQ_CHUNK_CAPACITY - 1) / CBQ_CHUNK_CAPACITY * CBQ_CHUNK_CAPACITY;
+}
+
+/* Reverse range of blocks in map (for rotation without temp memory) */
+static void CBQ_reverseBlocks__(CBQContainer_t** first, CBQContainer_t** last)
+{
+    CBQContainer_t* tmpBlock;
+
+    while (first < last) {
+        SWAP_BY_TEMP(*first, *last, tmpBlock);
+        ++first, --last;
+    }
+}
+
+/* ++s-----r+++++++  (divided segments)
+ * ++s--|~~~~~~~~|---r+++++++  (new blocks are rotated from map end into place after store block)
+ * ++s~~|~~~~~~~-|---r+++++++  (rest cells of store block are swapped with cells of last new block)
+ * Containers are not reordered, only map of blocks and not more than one block of cells.
+ */
+static int CBQ_incChunksCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMaxCapacityLimit)
+{
+    int errSt;
+    int usedGeneratedIncrement;
+    size_t remainder, blocksCount, newBlocksCount, insBlock, sOffset;
+    CBQContainer_t** newMap;
+
+    /* in static mode, the capacity cannot increase */
+    if (trustedQueue->incCapacityMode == CBQ_SM_STATIC)
+        return CBQ_ERR_STATIC_CAPACITY_OVERFLOW;
+
+    /* Get generated delta */
+    if (!delta) {
+        usedGeneratedIncrement = 1;
+        delta = trustedQueue->incCapacity;
+    }
+    else
+        usedGeneratedIncrement = 0;
+
+    /* capacity grows by whole blocks */
+    if (delta <= CBQ_QUEUE_MAX_CAPACITY - trustedQueue->capacity)
+        delta = CBQ_roundUpChunks__(delta);
+
+    /* Checking the delta */
+    remainder = (size_t) (trustedQueue->incCapacityMode == CBQ_SM_LIMIT?
+                        trustedQueue->maxCapacityLimit :
+                        CBQ_QUEUE_MAX_CAPACITY) - trustedQueue->capacity;
+
+    if (remainder < delta) {
+        /* if limit has been reached or the delta cannot be aligned */
+        if (!(remainder >= CBQ_CHUNK_CAPACITY && alignToMaxCapacityLimit)) {
+            if (trustedQueue->incCapacityMode == CBQ_SM_LIMIT)
+                return CBQ_ERR_LIMIT_CAPACITY_OVERFLOW;
+            else
+                return CBQ_ERR_MAX_CAPACITY_OVERFLOW;
+        } else
+            delta = remainder / CBQ_CHUNK_CAPACITY * CBQ_CHUNK_CAPACITY;
+    }
+
+    blocksCount = trustedQueue->capacity / CBQ_CHUNK_CAPACITY;
+    newBlocksCount = delta / CBQ_CHUNK_CAPACITY;
+
+    /* New map with new blocks at its end (old map stays as is on failure) */
+    newMap = (CBQContainer_t**) CBQ_QMALLOC(trustedQueue, sizeof(CBQContainer_t*) * (blocksCount + newBlocksCount));
+    if (newMap == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    errSt = CBQ_containersBlocksInit__(trustedQueue, newMap + blocksCount, newBlocksCount);
+    if (errSt) {
+        CBQ_QMEMFREE(trustedQueue, newMap, sizeof(CBQContainer_t*) * (blocksCount + newBlocksCount));
+        return errSt;
+    }
+
+    for (insBlock = 0; insBlock < blocksCount; insBlock++)
+        newMap[insBlock] = trustedQueue->coBlocks[insBlock];
+
+    CBQ_QMEMFREE(trustedQueue, trustedQueue->coBlocks, sizeof(CBQContainer_t*) * blocksCount);
+    trustedQueue->coBlocks = newMap;
+
+    /* Placing new blocks */
+    /* ---b--- -> b------~~~ */
+    if (trustedQueue->status == CBQ_ST_EMPTY)
+        trustedQueue->rId = trustedQueue->sId = 0;
+    /* s--r+++ -> ---r+++s~~~ */
+    else if (!trustedQueue->sId)
+        trustedQueue->sId = trustedQueue->capacity;
+    /* ++s--r+ -> ++s~~~--r+ */
+    else if (trustedQueue->sId <= trustedQueue->rId) {
+        sOffset = trustedQueue->sId % CBQ_CHUNK_CAPACITY;
+        insBlock = trustedQueue->sId / CBQ_CHUNK_CAPACITY + !!sOffset;
+
+        if (insBlock < blocksCount) {
+            CBQ_reverseBlocks__(trustedQueue->coBlocks + insBlock, trustedQueue->coBlocks + (blocksCount - 1));
+            CBQ_reverseBlocks__(trustedQueue->coBlocks + blocksCount, trustedQueue->coBlocks + (blocksCount + newBlocksCount - 1));
+            CBQ_reverseBlocks__(trustedQueue->coBlocks + insBlock, trustedQueue->coBlocks + (blocksCount + newBlocksCount - 1));
+        }
+
+        if (sOffset)
+            CBQ_containersSwapping__(trustedQueue->coBlocks[insBlock - 1] + sOffset,
+                                     trustedQueue->coBlocks[insBlock + newBlocksCount - 1] + sOffset, CBQ_CHUNK_CAPACITY - sOffset, 0);
+
+        trustedQueue->rId += delta;
+    }
+    /* --r++s- stays as is */
+
+    if (usedGeneratedIncrement)
+        CBQ_incIterCapacityChange__(trustedQueue, CBQ_getIncIterVector__(trustedQueue));
+
+    /* Sets new incremented capacity and status */
+    trustedQueue->capacity += delta;
+
+    if (trustedQueue->status == CBQ_ST_FULL)
+        trustedQueue->status = CBQ_ST_STABLE;
+
+    CBQ_MSGPRINT("Queue capacity incremented");
+    CBQ_DRAWSCHEME_IN(trustedQueue);
+
+    return 0;
+}
+
+/* Frees blocks of map range and shifts ids which are after them */
+static void CBQ_releaseBlocks__(CBQueue_t* trustedQueue, size_t blocksCount, size_t first, size_t count)
+{
+    const size_t firstCell = first * CBQ_CHUNK_CAPACITY;
+
+    CBQ_containersBlocksFree__(trustedQueue, trustedQueue->coBlocks + first, count);
+
+    for (; first + count < blocksCount; first++)
+        trustedQueue->coBlocks[first] = trustedQueue->coBlocks[first + count];
+
+    if (trustedQueue->rId > firstCell)
+        trustedQueue->rId -= count * CBQ_CHUNK_CAPACITY;
+    if (trustedQueue->sId > firstCell)
+        trustedQueue->sId -= count * CBQ_CHUNK_CAPACITY;
+}
+
+/* --r++s--|-------|-------  ->  --r++s--
+ * Only blocks without used cells (which are after store block) are released, one block always stays.
+ */
+static int CBQ_decChunksCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUsedCells)
+{
+    size_t size, blocksCount, freeBlocksCount, firstBlock, endCount, beforeFree;
+    CBQContainer_t** newMap;
+
+    size = CBQ_getSizeByCells__(trustedQueue);
+
+    if (!delta)
+        delta = trustedQueue->capacity - size;
+    else if (delta > CBQ_QUEUE_MAX_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    /* ---b--- -> b------ */
+    if (trustedQueue->status == CBQ_ST_EMPTY)
+        trustedQueue->rId = trustedQueue->sId = 0;
+
+    /* Count free blocks (cells of store block before the next block are not counted) */
+    blocksCount = trustedQueue->capacity / CBQ_CHUNK_CAPACITY;
+    beforeFree = CBQ_roundUpChunks__(trustedQueue->sId) - trustedQueue->sId;
+
+    if (trustedQueue->capacity - size >= beforeFree)
+        freeBlocksCount = (trustedQueue->capacity - size - beforeFree) / CBQ_CHUNK_CAPACITY;
+    else
+        freeBlocksCount = 0;
+
+    if (freeBlocksCount == blocksCount)
+        freeBlocksCount--;
+
+    if (delta > freeBlocksCount * CBQ_CHUNK_CAPACITY) {
+        if (alignToUsedCells)
+            delta = freeBlocksCount * CBQ_CHUNK_CAPACITY; // to delta balance
+        else
+            return CBQ_ERR_ENGCELLS_NOT_FIT_IN_NEWCAPACITY;
+    }
+
+    delta /= CBQ_CHUNK_CAPACITY;
+    if (!delta)
+        return CBQ_ERR_CUR_CH_CAPACITY_NOT_AFFECT;
+
+    /* map is replaced by smaller one before blocks are released (so its failure changes nothing) */
+    newMap = (CBQContainer_t**) CBQ_QMALLOC(trustedQueue, sizeof(CBQContainer_t*) * (blocksCount - delta));
+    if (newMap == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    /* Release free blocks (they may continue from the start of map) */
+    firstBlock = (trustedQueue->sId + beforeFree) / CBQ_CHUNK_CAPACITY;
+    if (firstBlock == blocksCount)
+        firstBlock = 0;
+
+    endCount = blocksCount - firstBlock < delta? blocksCount - firstBlock : delta;
+    CBQ_releaseBlocks__(trustedQueue, blocksCount, firstBlock, endCount);
+    if (delta > endCount)
+        CBQ_releaseBlocks__(trustedQueue, blocksCount - endCount, 0, delta - endCount);
+
+    for (firstBlock = 0; firstBlock < blocksCount - delta; firstBlock++)
+        newMap[firstBlock] = trustedQueue->coBlocks[firstBlock];
+
+    CBQ_QMEMFREE(trustedQueue, trustedQueue->coBlocks, sizeof(CBQContainer_t*) * blocksCount);
+    trustedQueue->coBlocks = newMap;
+
+    CBQ_incIterCapacityChange__(trustedQueue, 0); // when reducing the capacity, it is logical to reduce the incCapacity var
+
+    /* Sets new capacity and status */
+    trustedQueue->capacity -= delta * CBQ_CHUNK_CAPACITY;
+    if (trustedQueue->sId == trustedQueue->capacity)
+        trustedQueue->sId = 0;
+
+    if (size == trustedQueue->capacity) // no free cells left
+        trustedQueue->status = CBQ_ST_FULL;
+
+    CBQ_MSGPRINT("Queue capacity decremented");
+    CBQ_DRAWSCHEME_IN(trustedQueue);
+
+    return 0;
+}
+#endif // CBQ_CHUNKED_STORAGE
+
+#ifndef CBQ_CHUNKED_STORAGE
+static int CBQ_incCellsCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMaxCapacityLimit);
+static int CBQ_decCellsCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUsedCells);
+#endif // CBQ_CHUNKED_STORAGE
+
 int CBQ_incCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMaxCapacityLimit)
+{
+    #if defined(CBQ_POW2_CAPACITY)
+    int errSt;
+
+    CBQ_idsToCells__(trustedQueue);
+    errSt = CBQ_incCellsCapacity__(trustedQueue, delta, alignToMaxCapacityLimit);
+    CBQ_cellsToIds__(trustedQueue);
+
+    return errSt;
+    #elif defined(CBQ_CHUNKED_STORAGE)
+    return CBQ_incChunksCapacity__(trustedQueue, delta, alignToMaxCapacityLimit);
+    #else
+    return CBQ_incCellsCapacity__(trustedQueue, delta, alignToMaxCapacityLimit);
+    #endif // CBQ_POW2_CAPACITY
+}
+
+int CBQ_decCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUsedCells)
+{
+    #if defined(CBQ_POW2_CAPACITY)
+    int errSt;
+
+    CBQ_idsToCells__(trustedQueue);
+    errSt = CBQ_decCellsCapacity__(trustedQueue, delta, alignToUsedCells);
+    CBQ_cellsToIds__(trustedQueue);
+
+    return errSt;
+    #elif defined(CBQ_CHUNKED_STORAGE)
+    return CBQ_decChunksCapacity__(trustedQueue, delta, alignToUsedCells);
+    #else
+    return CBQ_decCellsCapacity__(trustedQueue, delta, alignToUsedCells);
+    #endif // CBQ_POW2_CAPACITY
+}
+
+#ifndef CBQ_CHUNKED_STORAGE
+/* ++s------r+++++~~~~   (~ - new cells after realloc)
+ * ---------r+++++++s~   (start segment is shorter, it is moved after end segment)
+ * ++s-----------r+++++  (otherwise end segment is shifted to the end of new capacity)
+ * Cells are moved by swapping with new cells, so there is no temp memory and only
+ * the shorter segment is copied. Capacity is still old on that stage.
+ */
+static void CBQ_moveDividedSeg__(CBQueue_t* trustedQueue, size_t delta)
+{
+    const size_t endSegLen = trustedQueue->capacity - trustedQueue->rId;
+
+    if (trustedQueue->sId <= delta && trustedQueue->sId <= endSegLen) {
+        CBQ_containersSwapping__(trustedQueue->coArr, trustedQueue->coArr + trustedQueue->capacity, trustedQueue->sId, 0);
+        trustedQueue->sId += trustedQueue->capacity;
+        if (trustedQueue->sId == trustedQueue->capacity + delta)
+            trustedQueue->sId = 0;
+    } else {
+        /* in reverse, because areas may overlap */
+        CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->capacity - 1),
+                                 trustedQueue->coArr + (trustedQueue->capacity + delta - 1), endSegLen, 1);
+        trustedQueue->rId += delta;
+    }
+}
+
+static int CBQ_incCellsCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMaxCapacityLimit)
 {
     int errSt;
     int usedGeneratedIncrement;
@@ -31,6 +360,12 @@ int CBQ_incCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMa
     else
         usedGeneratedIncrement = 0;
 
+    /* new capacity is aligned up to power of two (limits are powers of two too) */
+    #ifdef CBQ_POW2_CAPACITY
+    if (delta <= CBQ_QUEUE_MAX_CAPACITY - trustedQueue->capacity)
+        delta = CBQ_roundUpPow2__(trustedQueue->capacity + delta) - trustedQueue->capacity;
+    #endif // CBQ_POW2_CAPACITY
+
     /* Checking the delta */
     remainder = (size_t) (trustedQueue->incCapacityMode == CBQ_SM_LIMIT?
                         trustedQueue->maxCapacityLimit :
@@ -47,40 +382,23 @@ int CBQ_incCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMa
             delta = remainder;
     }
 
-    /* Ordering cells */
-    if (!trustedQueue->sId) {
-        if (trustedQueue->status != CBQ_ST_EMPTY)
-            trustedQueue->sId = trustedQueue->capacity;
-    }
-    else if (trustedQueue->sId < trustedQueue->rId) {    // when segments of occupied cells are divided
-        size_t new_sId;
-        errSt = CBQ_orderingDividedSegs__(trustedQueue, &new_sId);
-        if (errSt)
-            return errSt;
-        trustedQueue->rId = 0;
-        trustedQueue->sId = new_sId;
-    }
-    else if (trustedQueue->status == CBQ_ST_FULL)  { // segments are also divided and there are no empty cells.
-        errSt = CBQ_orderingDividedSegsInFullQueue__(trustedQueue);
-        if (errSt)
-            return errSt;
-        trustedQueue->rId = 0;
+    /* s--r+++ -> ---r+++s */
+    if (!trustedQueue->sId && trustedQueue->status != CBQ_ST_EMPTY)
         trustedQueue->sId = trustedQueue->capacity;
-    }
 
     /* Realloc mem to new capacity */
-    errSt = CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity + delta);
+    errSt = CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity, trustedQueue->capacity + delta);
     if (errSt)
         return errSt;
 
     /* Init new allocated containers */
-    errSt = CBQ_containersRangeInit__(trustedQueue->coArr + trustedQueue->capacity, trustedQueue->initArgCap, delta, REST_MEM);
+    errSt = CBQ_containersRangeInit__(trustedQueue, trustedQueue->coArr + trustedQueue->capacity, trustedQueue->initArgCap, delta, REST_MEM);
     if (errSt) {
 
         if (errSt != CBQ_ERR_MEM_BUT_RESTORED)
             return errSt;
 
-        if (CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity))
+        if (CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity + delta, trustedQueue->capacity))
             return CBQ_ERR_MEM_ALLOC_FAILED; // totally failed
 
         if (trustedQueue->sId == trustedQueue->capacity)
@@ -89,6 +407,10 @@ int CBQ_incCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMa
         return errSt;
     }
 
+    /* when segments of occupied cells are divided (or there are no empty cells) */
+    if (trustedQueue->sId <= trustedQueue->rId && trustedQueue->status != CBQ_ST_EMPTY)
+        CBQ_moveDividedSeg__(trustedQueue, delta);
+
     if (usedGeneratedIncrement)
         CBQ_incIterCapacityChange__(trustedQueue, CBQ_getIncIterVector__(trustedQueue));
 
@@ -103,6 +425,7 @@ int CBQ_incCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToMa
 
     return 0;
 }
+#endif // CBQ_CHUNKED_STORAGE
 
 void CBQ_incIterCapacityChange__(CBQueue_t* trustedQueue, const int direction)
 {
@@ -133,14 +456,18 @@ int CBQ_getIncIterVector__(const CBQueue_t* trustedQueue)
     }
 }
 
-int CBQ_decCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUsedCells)
-{
+#ifndef CBQ_CHUNKED_STORAGE
+static int CBQ_decCellsCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUsedCells)
+{
     int errSt;
     size_t size;
-    ssize_t remainder;
+    ssize_t remainder;
+    #if REST_MEM == 1
+    int shifted = 0;    // end segment is moved back on restore
+    #endif // REST_MEM
 
     /* Check and align delta */
-    size = CBQ_getSizeByIndexes__(trustedQueue);
+    size = CBQ_getSizeByCells__(trustedQueue);
 
     if (!delta)
         delta = trustedQueue->capacity - size;
@@ -159,43 +486,61 @@ int CBQ_decCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUs
             return CBQ_ERR_ENGCELLS_NOT_FIT_IN_NEWCAPACITY;
     }
 
-    /* Offset or ordeing cells (for 4 cases)*/
+    /* new capacity is aligned up to power of two */
+    #ifdef CBQ_POW2_CAPACITY
+    {
+        size_t newCapacity = CBQ_roundUpPow2__(trustedQueue->capacity - delta);
+
+        if (newCapacity == trustedQueue->capacity)
+            return CBQ_ERR_CUR_CH_CAPACITY_NOT_AFFECT;
+
+        remainder += (ssize_t) (newCapacity - (trustedQueue->capacity - delta));
+        delta = trustedQueue->capacity - newCapacity;
+    }
+    #endif // CBQ_POW2_CAPACITY
+
+    /* Offset cells (for 3 cases, ids are moved in place) */
     /* ---b--- -> b------ */
     if (trustedQueue->status == CBQ_ST_EMPTY)
         trustedQueue->rId = trustedQueue->sId = 0;
-    else if (trustedQueue->rId) {
-
-    /* s--r+++ -> ---r+++s */
-        if (!trustedQueue->sId)
-            trustedQueue->sId = trustedQueue->capacity;
 
     /* --r++s- -> r++s---   (if for example delta == 3, capacity - sId == 2) */
-        if (trustedQueue->rId < trustedQueue->sId) {
-            if (trustedQueue->capacity - trustedQueue->sId < delta) {
-                CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->rId), trustedQueue->coArr, size, 0);
-                trustedQueue->rId = 0;
-            }
-    /* ++s--r+ -> r+++s-- */
-        } else {
-            errSt = CBQ_orderingDividedSegs__(trustedQueue, NULL);
-            if (errSt)
-                return errSt;
+    else if (trustedQueue->rId < trustedQueue->sId || !trustedQueue->sId) {
+        if (trustedQueue->capacity - (trustedQueue->rId + size) < delta) {
+            CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->rId), trustedQueue->coArr, size, 0);
             trustedQueue->rId = 0;
+            trustedQueue->sId = size;
         }
+
+    /* ++s---r+ -> ++s-r+-- (end segment is shifted into free cells) */
+    } else {
+        CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->rId), trustedQueue->coArr + (trustedQueue->rId - delta),
+                                 trustedQueue->capacity - trustedQueue->rId, 0);
+        trustedQueue->rId -= delta;
+        #if REST_MEM == 1
+        shifted = 1;
+        #endif // REST_MEM
     }
 
     /* Free unused container args */
-    CBQ_containersRangeFree__(trustedQueue->coArr + (trustedQueue->capacity - delta), delta);
+    CBQ_containersRangeFree__(trustedQueue, trustedQueue->coArr + (trustedQueue->capacity - delta), delta);
 
     /* Mem reallocation */
-    errSt = CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity - delta);
+    errSt = CBQ_reallocCapacity__(trustedQueue, trustedQueue->capacity, trustedQueue->capacity - delta);
     if (errSt) {    // mem alloc error
 
         #if REST_MEM == 1
         int errStRest = 0;
-        errStRest = CBQ_containersRangeInit__(trustedQueue->coArr, trustedQueue->initArgCap, delta, 1);
-        if (!errStRest)
+        errStRest = CBQ_containersRangeInit__(trustedQueue, trustedQueue->coArr + (trustedQueue->capacity - delta), trustedQueue->initArgCap, delta, 1);
+        if (!errStRest) {
+            /* end segment is shifted back (in reverse, because areas may overlap) */
+            if (shifted) {
+                CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->capacity - delta - 1),
+                                         trustedQueue->coArr + (trustedQueue->capacity - 1), trustedQueue->capacity - delta - trustedQueue->rId, 1);
+                trustedQueue->rId += delta;
+            }
             return CBQ_ERR_MEM_BUT_RESTORED;
+        }
         #endif // REST_MEM
 
         return errSt;
@@ -206,10 +551,10 @@ int CBQ_decCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUs
     /* Sets new capacity and sId */
     trustedQueue->capacity -= delta;
     trustedQueue->sId = trustedQueue->rId + size;
-    if (trustedQueue->sId == trustedQueue->capacity)
-        trustedQueue->sId = 0;
+    if (trustedQueue->sId >= trustedQueue->capacity)
+        trustedQueue->sId -= trustedQueue->capacity;
 
-    if (!remainder) // no free cells left
+    if (size == trustedQueue->capacity) // no free cells left
         trustedQueue->status = CBQ_ST_FULL;
 
     CBQ_MSGPRINT("Queue capacity decremented");
@@ -218,11 +563,11 @@ int CBQ_decCapacity__(CBQueue_t* trustedQueue, size_t delta, const int alignToUs
     return 0;
 }
 
-int CBQ_reallocCapacity__(CBQueue_t* trustedQueue, size_t newCapacity)
+int CBQ_reallocCapacity__(CBQueue_t* trustedQueue, size_t oldCapacity, size_t newCapacity)
 {
     void* reallocp; // for safety old data
 
-    reallocp = CBQ_REALLOC(trustedQueue->coArr, sizeof(CBQContainer_t) * newCapacity);
+    reallocp = CBQ_QREALLOC(trustedQueue, trustedQueue->coArr, sizeof(CBQContainer_t) * oldCapacity, sizeof(CBQContainer_t) * newCapacity);
     if (reallocp == NULL)
         return CBQ_ERR_MEM_ALLOC_FAILED;
 
@@ -230,80 +575,7 @@ int CBQ_reallocCapacity__(CBQueue_t* trustedQueue, size_t newCapacity)
 
     return 0;
 }
-
-/* ++s------r+++++++
- * ++-------~~~~~~~~    (move cells in temp at r point)
- * ~~-------~~~~~~~~    (in temp all engaged cells)
- *           -------    (swap free cells with last by reverse iterations)
- * ++++++++++-------    (move from temp)
- * r+++++++++s------
- * The last queue states is where st. pointer returns to start cells in array
- * and its index has become less than index of read pointer or equal to that.
- * Situation where any pointers indicates first cell will not occure on that stage.
- * There are two options - when we have free cells or not.
- * In the first case all busy cells are written in restored order into allocated memory.
- * Then the free cells are shifted to the end of the array by swapping.
- * Here the situation is similar to offset, but now the cells are changing from the end.
- * After all, we copy back the occupied cells from the beginning.
- */
-int CBQ_orderingDividedSegs__(CBQueue_t* trustedQueue, size_t* sizeP)
-{
-    CBQContainer_t* tmpCoArr;
-    size_t size;
-
-    size = CBQ_getSizeByIndexes__(trustedQueue); // as new sId pos
-
-    tmpCoArr = (CBQContainer_t*) CBQ_MALLOC(sizeof(CBQContainer_t) * size);
-    if (tmpCoArr == NULL)
-        return CBQ_ERR_MEM_ALLOC_FAILED;
-
-    /* copy cells between rId and last cell */
-    CBQ_containersCopy__(trustedQueue->coArr + (trustedQueue->rId), tmpCoArr, trustedQueue->capacity - trustedQueue->rId);
-    /* copy cells before sId into next free cells */
-    CBQ_containersCopy__(trustedQueue->coArr, tmpCoArr + (trustedQueue->capacity - trustedQueue->rId), trustedQueue->sId);
-    /* copy space of free cells to end of array with swap in reverse (to avoid data overlay) */
-    CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->rId - 1), // at last free cell
-                             trustedQueue->coArr + (trustedQueue->capacity - 1), trustedQueue->capacity - size, 1);
-    /* copy to start array from temp */
-    CBQ_containersCopy__(tmpCoArr, trustedQueue->coArr, size);
-
-    CBQ_MEMFREE(tmpCoArr);
-
-    if (sizeP)
-        *sizeP = size;
-    return 0;
-}
-
-/* +++++++++b+++++++
- * +++++++++~~~~~~~~
- * ~~~~~~~~~~~~~~~~~    (no free cells for swapping)
- * +++++++++++++++++
- * r++++++++++++++++s
- * Looks like ordering with divided segments, but this requires less memory and cycles.
- * We reserve the first half of the cells, shift the second to the beginning
- * and copy the first at the end.
- */
-int CBQ_orderingDividedSegsInFullQueue__(CBQueue_t* trustedQueue)
-{
-    CBQContainer_t* tmpCoArr;
-    size_t capacityOfSegment;
-
-    tmpCoArr = (CBQContainer_t*) CBQ_MALLOC(sizeof(CBQContainer_t) * trustedQueue->sId);
-    if (tmpCoArr == NULL)
-        return CBQ_ERR_MEM_ALLOC_FAILED;
-
-    /* copy cells before sId into temp */
-    CBQ_containersCopy__(trustedQueue->coArr, tmpCoArr, trustedQueue->sId);
-    capacityOfSegment = trustedQueue->capacity - trustedQueue->rId; // get capacity of second part
-    /* swap cells with second part */
-    CBQ_containersSwapping__(trustedQueue->coArr + (trustedQueue->rId), trustedQueue->coArr, capacityOfSegment, 0);
-    /* copy first part into place after seconf part */
-    CBQ_containersCopy__(tmpCoArr, trustedQueue->coArr + (capacityOfSegment), trustedQueue->sId);
-
-    CBQ_MEMFREE(tmpCoArr);
-
-    return 0;
-}
+#endif // CBQ_CHUNKED_STORAGE
 
 int CBQ_ChangeCapacity(CBQueue_t* queue, const int changeTowards, size_t customNewCapacity, const int adaptByLimits)
 {
@@ -314,8 +586,12 @@ int CBQ_ChangeCapacity(CBQueue_t* queue, const int changeTowards, size_t customN
     #ifndef NO_EXCEPTIONS_OF_BUSY
     if (queue->execSt == CBQ_EST_EXEC)
         return CBQ_ERR_IS_BUSY;
-    #endif // NO_EXCEPTIONS_OF_BUSY
-
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* reserved args storage must not be moved */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     CBQ_MSGPRINT("Queue capacity changing...");
 
     /* by selected mode with auto-dec/inc params */
@@ -364,8 +640,12 @@ int CBQ_ChangeIncCapacityMode(CBQueue_t* queue, int newIncCapacityMode, size_t n
     #ifndef NO_EXCEPTIONS_OF_BUSY
     if (queue->execSt == CBQ_EST_EXEC)
         return CBQ_ERR_IS_BUSY;
-    #endif // NO_EXCEPTIONS_OF_BUSY
-
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* reserved args storage must not be moved */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     CBQ_MSGPRINT("Queue capacity mode changing...");
 
     if (newIncCapacityMode != CBQ_SM_LIMIT) {
@@ -376,6 +656,14 @@ int CBQ_ChangeIncCapacityMode(CBQueue_t* queue, int newIncCapacityMode, size_t n
         if (newMaxCapacityLimit < CBQ_QUEUE_MIN_CAPACITY || newMaxCapacityLimit > CBQ_QUEUE_MAX_CAPACITY)
             return CBQ_ERR_ARG_OUT_OF_RANGE;
 
+        #ifdef CBQ_POW2_CAPACITY
+        newMaxCapacityLimit = CBQ_roundDownPow2__(newMaxCapacityLimit);
+        #endif // CBQ_POW2_CAPACITY
+
+        #ifdef CBQ_CHUNKED_STORAGE
+        newMaxCapacityLimit = CBQ_roundUpChunks__(newMaxCapacityLimit);
+        #endif // CBQ_CHUNKED_STORAGE
+
         /* capacity does not fit into new limits */
         if (newMaxCapacityLimit < queue->capacity) {
 
@@ -404,3 +692,71 @@ int CBQ_ChangeIncCapacityMode(CBQueue_t* queue, int newIncCapacityMode, size_t n
     CBQ_MSGPRINT("Queue capacity mode is changed");
     return 0;
 }
+
+int CBQ_SetAutoShrink(CBQueue_t* queue, unsigned int lowWaterPercent, unsigned int hysteresisExecs, clock_t minInterval, size_t minCapacity)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (lowWaterPercent > CBQ_SHRINK_MAX_LOW_WATER)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    if (minCapacity < CBQ_QUEUE_MIN_CAPACITY || minCapacity > CBQ_QUEUE_MAX_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    #ifdef CBQ_POW2_CAPACITY
+    minCapacity = CBQ_roundUpPow2__(minCapacity);
+    #endif // CBQ_POW2_CAPACITY
+
+    #ifdef CBQ_CHUNKED_STORAGE
+    minCapacity = CBQ_roundUpChunks__(minCapacity);
+    #endif // CBQ_CHUNKED_STORAGE
+
+    queue->shrinkLowWater = lowWaterPercent;
+    queue->shrinkHysteresis = hysteresisExecs;
+    queue->shrinkMinCapacity = minCapacity;
+    queue->shrinkInterval = CBQ_CLOCK_TO_TICKS(minInterval);
+    queue->lowWaterExecs = 0;
+    queue->lastShrinkTime = CBQ_FRESHTICKS();
+
+    CBQ_MSGPRINT("Queue auto shrink policy is set");
+    return 0;
+}
+
+/* Called by exec with turned on policy.
+ * Capacity is halved, so after shrink size stays above low-water mark (< 50%)
+ * and next shrink needs new series of low-water execs (hysteresis).
+ */
+void CBQ_autoShrink__(CBQueue_t* trustedQueue)
+{
+    size_t size, newCapacity;
+    CBQTicks_t curTime;
+
+    /* reserved args storage must not be moved until commit */
+    if (trustedQueue->reserved || trustedQueue->incCapacityMode == CBQ_SM_STATIC || trustedQueue->capacity <= trustedQueue->shrinkMinCapacity)
+        return;
+
+    /* size < capacity * lowWater / 100 (without overflow) */
+    size = CBQ_getSizeByIndexes__(trustedQueue);
+    if (size >= trustedQueue->capacity / 100 * trustedQueue->shrinkLowWater + trustedQueue->capacity % 100 * trustedQueue->shrinkLowWater / 100) {
+        trustedQueue->lowWaterExecs = 0;
+        return;
+    }
+
+    if (++trustedQueue->lowWaterExecs < trustedQueue->shrinkHysteresis)
+        return;
+
+    curTime = CBQ_CURTICKS();
+    if (curTime - trustedQueue->lastShrinkTime < trustedQueue->shrinkInterval)
+        return;
+
+    newCapacity = trustedQueue->capacity / 2;
+    if (newCapacity < trustedQueue->shrinkMinCapacity)
+        newCapacity = trustedQueue->shrinkMinCapacity;
+
+    /* errors are not critical here, queue just keeps its capacity */
+    if (!CBQ_decCapacity__(trustedQueue, trustedQueue->capacity - newCapacity, 1))
+        CBQ_MSGPRINT("Queue capacity is auto shrunk");
+
+    trustedQueue->lowWaterExecs = 0;
+    trustedQueue->lastShrinkTime = curTime;
+}
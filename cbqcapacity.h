@@ -6,12 +6,21 @@
 
 int CBQ_incCapacity__(CBQueue_t*, size_t, const int);
 int CBQ_decCapacity__(CBQueue_t*, size_t, const int);
-int CBQ_reallocCapacity__(CBQueue_t*, size_t);
-int CBQ_orderingDividedSegs__(CBQueue_t*, size_t*);
-int CBQ_orderingDividedSegsInFullQueue__(CBQueue_t*);
+#ifndef CBQ_CHUNKED_STORAGE
+int CBQ_reallocCapacity__(CBQueue_t*, size_t, size_t);
+#endif // CBQ_CHUNKED_STORAGE
 void CBQ_incIterCapacityChange__(CBQueue_t*, const int);
 int CBQ_getIncIterVector__(const CBQueue_t*);     // ret vector
+void CBQ_autoShrink__(CBQueue_t*);
 size_t CBQ_getSizeByIndexes__(const CBQueue_t*);
+size_t CBQ_getSizeByCells__(const CBQueue_t*);
+
+size_t CBQ_roundUpPow2__(size_t);
+size_t CBQ_roundDownPow2__(size_t);
+
+#ifdef CBQ_CHUNKED_STORAGE
+size_t CBQ_roundUpChunks__(size_t);
+#endif // CBQ_CHUNKED_STORAGE
 
 int CBQ_ChangeCapacity(CBQueue_t* queue, const int changeTowards, size_t customNewCapacity, const int adaptByLimits);
 int CBQ_ChangeIncCapacityMode(CBQueue_t* queue, int newIncCapacityMode, size_t newMaxCapacityLimit, const int tryToAdaptCapacity, const int adaptMaxCapacityLimit);
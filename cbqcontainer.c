@@ -1,26 +1,128 @@
+#include <string.h>
 #include "cbqcontainer.h"
+#include "cbqpool.h"
 
-int CBQ_containersRangeInit__(CBQContainer_t* coFirst, unsigned int iniArgCap, size_t len, const int restore_pos_fail)
+/* Arena block head: pointer to next block and number of slots in block */
+#define ARENA_BLOCK_HEAD 2
+
+/* In lazy init mode containers memory is zeroed only (zero capacity marks uninited container) */
+#ifndef CBQ_LAZY_INIT
+    #define CBQ_CO_ALLOC(QUEUE, SIZE) \
+        CBQ_QMALLOC(QUEUE, SIZE)
+#else
+    #define CBQ_CO_ALLOC(QUEUE, SIZE) \
+        CBQ_allocZeroed__(QUEUE, SIZE)
+#endif // CBQ_LAZY_INIT
+
+/* ---------------- Default Allocator ---------------- */
+/* Methods of queue allocator by CBQ_ALLOC_METHODS */
+void* CBQ_defAlloc__(UNUSED void* ctx, size_t size)
+{
+    return CBQ_MALLOC(size);
+}
+
+void* CBQ_defResize__(UNUSED void* ctx, void* ptr, UNUSED size_t oldSize, size_t newSize)
+{
+    return CBQ_REALLOC(ptr, newSize);
+}
+
+void CBQ_defRelease__(UNUSED void* ctx, void* ptr, UNUSED size_t size)
+{
+    CBQ_MEMFREE(ptr);
+}
+
+void* CBQ_defAllocZeroed__(UNUSED void* ctx, size_t size)
+{
+    return CBQ_CALLOC(size);
+}
+
+void* CBQ_allocZeroed__(CBQueue_t* trustedQueue, size_t size)
+{
+    void* ptr;
+
+    if (trustedQueue->allocator.allocZeroed != NULL)
+        return trustedQueue->allocator.allocZeroed(trustedQueue->allocator.ctx, size);
+
+    ptr = CBQ_QMALLOC(trustedQueue, size);
+    if (ptr != NULL)
+        memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/* Spilled args in heap are taken from args pool first (only for default allocator, see cbqpool.h) */
+CBQArg_t* CBQ_heapArgsAlloc__(CBQueue_t* trustedQueue, unsigned int capacity)
 {
+    #ifdef CBQ_ARGS_POOL
+    CBQArg_t* args;
+
+    if (CBQ_ARGS_POOLED(trustedQueue) && (args = CBQ_argsPoolTake__(capacity)) != NULL)
+        return args;
+    #endif // CBQ_ARGS_POOL
+
+    return (CBQArg_t*) CBQ_QMALLOC(trustedQueue, sizeof(CBQArg_t) * (size_t) capacity);
+}
+
+void CBQ_heapArgsFree__(CBQueue_t* trustedQueue, CBQArg_t* args, unsigned int capacity)
+{
+    #ifdef CBQ_ARGS_POOL
+    if (CBQ_ARGS_POOLED(trustedQueue) && !CBQ_argsPoolPut__(args, capacity))
+        return;
+    #endif // CBQ_ARGS_POOL
+
+    CBQ_QMEMFREE(trustedQueue, args, sizeof(CBQArg_t) * (size_t) capacity);
+}
+
+int CBQ_containersRangeInit__(CBQueue_t* trustedQueue, CBQContainer_t* coFirst, unsigned int iniArgCap, size_t len, const int restore_pos_fail)
+{
+    #ifdef CBQ_LAZY_INIT
+    /* args storage is taken on first push (see CBQ_containerLazyInit__) */
+    (void) trustedQueue, (void) iniArgCap, (void) restore_pos_fail;
+    memset(coFirst, 0, sizeof(CBQContainer_t) * len);
+    return 0;
+    #else
     MAY_REG CBQContainer_t* container = coFirst;
     MAY_REG size_t remLen = len;
-    int errSt = 0;
+    int errSt = 0,
+        useArena = 0;
+
+    /* args above inline area are taken from queue arena by one allocation */
+    if (iniArgCap > CBQ_INLINE_ARGS) {
+        if (!trustedQueue->argSlotCap)
+            trustedQueue->argSlotCap = iniArgCap;
+
+        if (trustedQueue->argSlotCap == iniArgCap) {
+            if (CBQ_argArenaReserve__(trustedQueue, len))
+                return restore_pos_fail? CBQ_ERR_MEM_BUT_RESTORED : CBQ_ERR_MEM_ALLOC_FAILED;
+            useArena = 1;
+        }
+    }
 
     do {
         /* Container init */
         *container = (CBQContainer_t) {
             .func = NULL,
-            .capacity = iniArgCap,
-            .argc = 0
+            .capacity = CBQ_INLINE_ARGS,
+            .argc = 0,
+            .argsSt = CBQ_AST_HEAP
 
             #ifdef CBQD_SCHEME
             , .label = '-'
             #endif // CBQD_SCHEME
         };
-        container->args = (CBQArg_t*) CBQ_MALLOC(sizeof(CBQArg_t) * iniArgCap);
-        if (container->args == NULL) {
-            errSt = CBQ_ERR_MEM_ALLOC_FAILED;
-            break;
+
+        /* small args capacity is covered by inline area */
+        if (useArena) {
+            container->args.ext = CBQ_argArenaTake__(trustedQueue);
+            container->capacity = iniArgCap;
+            container->argsSt = CBQ_AST_ARENA;
+        } else if (iniArgCap > CBQ_INLINE_ARGS) {
+            container->args.ext = CBQ_heapArgsAlloc__(trustedQueue, iniArgCap);
+            if (container->args.ext == NULL) {
+                errSt = CBQ_ERR_MEM_ALLOC_FAILED;
+                break;
+            }
+            container->capacity = iniArgCap;
         }
 
         container++;
@@ -30,20 +132,62 @@ int CBQ_containersRangeInit__(CBQContainer_t* coFirst, unsigned int iniArgCap, s
         if (!restore_pos_fail)
             return CBQ_ERR_MEM_ALLOC_FAILED;
 
-        CBQ_containersRangeFree__(coFirst, len - remLen);
+        CBQ_containersRangeFree__(trustedQueue, coFirst, len - remLen);
 
         return CBQ_ERR_MEM_BUT_RESTORED;
     }
 
     return 0;
+    #endif // CBQ_LAZY_INIT
 }
 
-void CBQ_containersRangeFree__(MAY_REG CBQContainer_t* container, MAY_REG size_t len)
+#ifdef CBQ_LAZY_INIT
+/* Gives args storage by init args capacity to uninited container (as in CBQ_containersRangeInit__) */
+int CBQ_containerLazyInit__(CBQueue_t* trustedQueue, CBQContainer_t* container)
 {
-    do {
-        CBQ_MEMFREE(container->args);
-        container++;
-    } while (--len);
+    const unsigned int iniArgCap = trustedQueue->initArgCap;
+
+    if (iniArgCap <= CBQ_INLINE_ARGS) {
+        container->capacity = CBQ_INLINE_ARGS;
+        return 0;
+    }
+
+    if (!trustedQueue->argSlotCap)
+        trustedQueue->argSlotCap = iniArgCap;
+
+    /* arena slots are reserved by small groups */
+    if (trustedQueue->argSlotCap == iniArgCap) {
+        if (!trustedQueue->argFreeCount && CBQ_argArenaReserve__(trustedQueue, INIT_INC_CAPACITY))
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+
+        container->args.ext = CBQ_argArenaTake__(trustedQueue);
+        container->argsSt = CBQ_AST_ARENA;
+    } else {
+        container->args.ext = CBQ_heapArgsAlloc__(trustedQueue, iniArgCap);
+        if (container->args.ext == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        container->argsSt = CBQ_AST_HEAP;
+    }
+
+    container->capacity = iniArgCap;
+
+    return 0;
+}
+#endif // CBQ_LAZY_INIT
+
+static void CBQ_extArgsFree__(CBQueue_t* trustedQueue, CBQArg_t* args, unsigned int capacity, unsigned int argsSt)
+{
+    if (argsSt == CBQ_AST_ARENA)
+        CBQ_argArenaPut__(trustedQueue, args);
+    else
+        CBQ_heapArgsFree__(trustedQueue, args, capacity);
+}
+
+void CBQ_containersRangeFree__(CBQueue_t* trustedQueue, MAY_REG CBQContainer_t* container, MAY_REG size_t len)
+{
+    for (; len; len--, container++)
+        if (!CBQ_CO_IS_INLINE(container))
+            CBQ_extArgsFree__(trustedQueue, container->args.ext, container->capacity, container->argsSt);
 }
 
 /* Accelerated cycle
@@ -77,24 +221,59 @@ void CBQ_containersCopy__(MAY_REG const CBQContainer_t *restrict srcp, MAY_REG C
 }
 
 /* ---------------- Args Methods ---------------- */
-int CBQ_changeArgsCapacity__(CBQContainer_t* container, unsigned int newCapacity, const int copyArgsData)
+int CBQ_changeArgsCapacity__(CBQueue_t* trustedQueue, CBQContainer_t* container, unsigned int newCapacity, const int copyArgsData)
 {
-    void* reallocp;
+    CBQArg_t* newArgs;
+    unsigned int newArgsSt;
 
     if (newCapacity > MAX_CAP_ARGS)
         return CBQ_ERR_ARG_OUT_OF_RANGE;
 
-    if (copyArgsData)
-        reallocp = CBQ_REALLOC(container->args, sizeof(CBQArg_t) * (size_t) newCapacity);
-    else {
-        CBQ_MEMFREE(container->args);   // free old mem alloc
-        reallocp = CBQ_MALLOC(sizeof(CBQArg_t) * (size_t) newCapacity);
+    /* back into inline area */
+    if (newCapacity <= CBQ_INLINE_ARGS) {
+        if (!CBQ_CO_IS_INLINE(container)) {
+            newArgs = container->args.ext;
+            if (copyArgsData && container->argc)
+                CBQ_copyArgs__(newArgs, container->args.inl, container->argc);
+            CBQ_extArgsFree__(trustedQueue, newArgs, container->capacity, container->argsSt);
+            container->capacity = CBQ_INLINE_ARGS;
+        }
+        return 0;
     }
-    if (reallocp == NULL)
-        return CBQ_ERR_MEM_ALLOC_FAILED;
 
-    container->args = (CBQArg_t*) reallocp;
+    if (newCapacity == container->capacity)
+        return 0;
+
+    /* free arena slot is used when it fits, otherwise args are spilled into heap */
+    if (newCapacity == trustedQueue->argSlotCap && trustedQueue->argFreeCount) {
+        newArgs = CBQ_argArenaTake__(trustedQueue);
+        newArgsSt = CBQ_AST_ARENA;
+    } else if (!CBQ_CO_IS_INLINE(container) && container->argsSt == CBQ_AST_HEAP && copyArgsData && !CBQ_ARGS_POOLED(trustedQueue)) {
+        newArgs = (CBQArg_t*) CBQ_QREALLOC(trustedQueue, container->args.ext,
+                                           sizeof(CBQArg_t) * (size_t) container->capacity, sizeof(CBQArg_t) * (size_t) newCapacity);
+        if (newArgs == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+
+        container->args.ext = newArgs;
+        container->capacity = newCapacity;
+        return 0;
+    } else {
+        newArgs = CBQ_heapArgsAlloc__(trustedQueue, newCapacity);
+        if (newArgs == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        newArgsSt = CBQ_AST_HEAP;
+    }
+
+    if (copyArgsData && container->argc)
+        CBQ_copyArgs__(CBQ_CO_ARGS(container), newArgs, container->argc);
+
+    /* free old args storage */
+    if (!CBQ_CO_IS_INLINE(container))
+        CBQ_extArgsFree__(trustedQueue, container->args.ext, container->capacity, container->argsSt);
+
+    container->args.ext = newArgs;
     container->capacity = newCapacity;
+    container->argsSt = newArgsSt;
 
     return 0;
 }
@@ -105,3 +284,184 @@ void CBQ_copyArgs__(MAY_REG const CBQArg_t *restrict src, MAY_REG CBQArg_t *rest
         *dest++ = *src++;
     } while (--len);
 }
+
+/* ---------------- Args Arena Methods ---------------- */
+/* Arena is a list of blocks with args slots (by argSlotCap size) for the queue,
+ * free slots are linked through their first arg. Slots are returned into
+ * the free list and reused by the queue, blocks are freed only with the queue.
+ */
+int CBQ_argArenaReserve__(CBQueue_t* trustedQueue, size_t slots)
+{
+    CBQArg_t* block;
+    CBQArg_t* slot;
+
+    if (trustedQueue->argFreeCount >= slots)
+        return 0;
+    slots -= trustedQueue->argFreeCount;
+
+    block = (CBQArg_t*) CBQ_QMALLOC(trustedQueue, sizeof(CBQArg_t) * (ARENA_BLOCK_HEAD + slots * trustedQueue->argSlotCap));
+    if (block == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    block[0].pVar = trustedQueue->argArena;
+    block[1].szVar = slots;
+    trustedQueue->argArena = block;
+    trustedQueue->argSlotsCount += slots;
+
+    /* in reverse, so slots are taken in address order */
+    slot = block + ARENA_BLOCK_HEAD + slots * trustedQueue->argSlotCap;
+    do {
+        slot -= trustedQueue->argSlotCap;
+        CBQ_argArenaPut__(trustedQueue, slot);
+    } while (--slots);
+
+    return 0;
+}
+
+CBQArg_t* CBQ_argArenaTake__(CBQueue_t* trustedQueue)
+{
+    CBQArg_t* slot = trustedQueue->argFreeSlots;
+
+    trustedQueue->argFreeSlots = (CBQArg_t*) slot->pVar;
+    trustedQueue->argFreeCount--;
+
+    return slot;
+}
+
+void CBQ_argArenaPut__(CBQueue_t* trustedQueue, CBQArg_t* slot)
+{
+    slot->pVar = trustedQueue->argFreeSlots;
+    trustedQueue->argFreeSlots = slot;
+    trustedQueue->argFreeCount++;
+}
+
+void CBQ_argArenaFree__(CBQueue_t* trustedQueue)
+{
+    CBQArg_t* block = trustedQueue->argArena;
+    CBQArg_t* next;
+
+    while (block) {
+        next = (CBQArg_t*) block[0].pVar;
+        CBQ_QMEMFREE(trustedQueue, block, sizeof(CBQArg_t) * (ARENA_BLOCK_HEAD + block[1].szVar * trustedQueue->argSlotCap));
+        block = next;
+    }
+
+    trustedQueue->argArena = trustedQueue->argFreeSlots = NULL;
+    trustedQueue->argSlotsCount = trustedQueue->argFreeCount = 0;
+}
+
+/* ---------------- Storage Methods ---------------- */
+/* Containers of queue are stored in one array of cells
+ * or in map of fixed-size blocks (with CBQ_CHUNKED_STORAGE).
+ */
+int CBQ_storageInit__(CBQueue_t* trustedQueue, size_t capacity)
+{
+    int errSt = 0;
+
+    #ifndef CBQ_CHUNKED_STORAGE
+    trustedQueue->coArr = (CBQContainer_t*) CBQ_CO_ALLOC(trustedQueue, sizeof(CBQContainer_t) * capacity);
+    if (trustedQueue->coArr == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    #ifndef CBQ_LAZY_INIT
+    errSt = CBQ_containersRangeInit__(trustedQueue, trustedQueue->coArr, trustedQueue->initArgCap, capacity, REST_MEM);
+    if (errSt)
+        CBQ_QMEMFREE(trustedQueue, trustedQueue->coArr, sizeof(CBQContainer_t) * capacity);
+    #endif // CBQ_LAZY_INIT
+    #else
+    trustedQueue->coBlocks = (CBQContainer_t**) CBQ_QMALLOC(trustedQueue, sizeof(CBQContainer_t*) * (capacity / CBQ_CHUNK_CAPACITY));
+    if (trustedQueue->coBlocks == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    errSt = CBQ_containersBlocksInit__(trustedQueue, trustedQueue->coBlocks, capacity / CBQ_CHUNK_CAPACITY);
+    if (errSt)
+        CBQ_QMEMFREE(trustedQueue, trustedQueue->coBlocks, sizeof(CBQContainer_t*) * (capacity / CBQ_CHUNK_CAPACITY));
+    #endif // CBQ_CHUNKED_STORAGE
+
+    return errSt;
+}
+
+void CBQ_storageFree__(CBQueue_t* trustedQueue)
+{
+    #ifndef CBQ_CHUNKED_STORAGE
+    CBQ_containersRangeFree__(trustedQueue, trustedQueue->coArr, trustedQueue->capacity);
+    CBQ_QMEMFREE(trustedQueue, trustedQueue->coArr, sizeof(CBQContainer_t) * trustedQueue->capacity);
+    #else
+    CBQ_containersBlocksFree__(trustedQueue, trustedQueue->coBlocks, trustedQueue->capacity / CBQ_CHUNK_CAPACITY);
+    CBQ_QMEMFREE(trustedQueue, trustedQueue->coBlocks, sizeof(CBQContainer_t*) * (trustedQueue->capacity / CBQ_CHUNK_CAPACITY));
+    #endif // CBQ_CHUNKED_STORAGE
+}
+
+/* Copies containers data only (spilled args of dest are still pointed to src args) */
+int CBQ_storageCopy__(CBQueue_t *restrict trustedDest, const CBQueue_t *restrict trustedSrc)
+{
+    #ifndef CBQ_CHUNKED_STORAGE
+    trustedDest->coArr = (CBQContainer_t*) CBQ_QMALLOC(trustedDest, sizeof(CBQContainer_t) * trustedSrc->capacity);
+    if (trustedDest->coArr == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    CBQ_containersCopy__(trustedSrc->coArr, trustedDest->coArr, trustedSrc->capacity);
+    #else
+    const size_t blocksCount = trustedSrc->capacity / CBQ_CHUNK_CAPACITY;
+    size_t i;
+
+    trustedDest->coBlocks = (CBQContainer_t**) CBQ_QMALLOC(trustedDest, sizeof(CBQContainer_t*) * blocksCount);
+    if (trustedDest->coBlocks == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    for (i = 0; i < blocksCount; i++) {
+        trustedDest->coBlocks[i] = (CBQContainer_t*) CBQ_QMALLOC(trustedDest, sizeof(CBQContainer_t) * CBQ_CHUNK_CAPACITY);
+        if (trustedDest->coBlocks[i] == NULL) {
+            while (i--)
+                CBQ_QMEMFREE(trustedDest, trustedDest->coBlocks[i], sizeof(CBQContainer_t) * CBQ_CHUNK_CAPACITY);
+            CBQ_QMEMFREE(trustedDest, trustedDest->coBlocks, sizeof(CBQContainer_t*) * blocksCount);
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        }
+        CBQ_containersCopy__(trustedSrc->coBlocks[i], trustedDest->coBlocks[i], CBQ_CHUNK_CAPACITY);
+    }
+    #endif // CBQ_CHUNKED_STORAGE
+
+    return 0;
+}
+
+#ifdef CBQ_CHUNKED_STORAGE
+int CBQ_containersBlocksInit__(CBQueue_t* trustedQueue, CBQContainer_t** blocks, size_t count)
+{
+    int errSt = 0;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        blocks[i] = (CBQContainer_t*) CBQ_CO_ALLOC(trustedQueue, sizeof(CBQContainer_t) * CBQ_CHUNK_CAPACITY);
+        if (blocks[i] == NULL) {
+            errSt = CBQ_ERR_MEM_ALLOC_FAILED;
+            break;
+        }
+
+        #ifndef CBQ_LAZY_INIT
+        errSt = CBQ_containersRangeInit__(trustedQueue, blocks[i], trustedQueue->initArgCap, CBQ_CHUNK_CAPACITY, REST_MEM);
+        if (errSt) {
+            CBQ_QMEMFREE(trustedQueue, blocks[i], sizeof(CBQContainer_t) * CBQ_CHUNK_CAPACITY);
+            break;
+        }
+        #endif // CBQ_LAZY_INIT
+    }
+
+    if (!errSt)
+        return 0;
+
+    #if REST_MEM == 1
+    CBQ_containersBlocksFree__(trustedQueue, blocks, i);
+    return CBQ_ERR_MEM_BUT_RESTORED;
+    #else
+    return CBQ_ERR_MEM_ALLOC_FAILED;
+    #endif // REST_MEM
+}
+
+void CBQ_containersBlocksFree__(CBQueue_t* trustedQueue, CBQContainer_t** blocks, size_t count)
+{
+    for (; count; count--, blocks++) {
+        CBQ_containersRangeFree__(trustedQueue, *blocks, CBQ_CHUNK_CAPACITY);
+        CBQ_QMEMFREE(trustedQueue, *blocks, sizeof(CBQContainer_t) * CBQ_CHUNK_CAPACITY);
+    }
+}
+#endif // CBQ_CHUNKED_STORAGE
@@ -10,9 +10,19 @@ typedef struct CBQContainer_t CBQContainer_t;
 struct CBQContainer_t {
 
     QCallback       func;
-    CBQArg_t*       args;
+
+    /* args are kept in container while their capacity fits inline area,
+     * otherwise they are spilled into heap (see CBQ_CO_ARGS)
+     */
+    union {
+        CBQArg_t    inl[CBQ_INLINE_ARGS];
+        CBQArg_t*   ext;
+    } args;
+
     unsigned int    capacity;
     unsigned int    argc;
+    unsigned int    argsSt;     // storage type of spilled args
+    unsigned int    gen;        // store generation of queue (see CBQHandle_t)
 
     #ifdef CBQD_SCHEME
     int label;
@@ -20,12 +30,60 @@ struct CBQContainer_t {
 
 };
 
+/* Container args storage state */
+#define CBQ_CO_IS_INLINE(CONTAINER) \
+    ((CONTAINER)->capacity <= CBQ_INLINE_ARGS)
+
+#define CBQ_CO_ARGS(CONTAINER) \
+    (CBQ_CO_IS_INLINE(CONTAINER)? (CONTAINER)->args.inl : (CONTAINER)->args.ext)
+
+/* Container without args storage (lazy init mode), it gets storage on first push */
+#ifdef CBQ_LAZY_INIT
+    #define CBQ_CO_IS_UNINITED(CONTAINER) \
+        (!(CONTAINER)->capacity)
+#endif // CBQ_LAZY_INIT
+
+/* Spilled args of queue with default allocator are shared with args pool */
+#ifdef CBQ_ARGS_POOL
+    #define CBQ_ARGS_POOLED(QUEUE) \
+        ((QUEUE)->allocator.alloc == CBQ_defAlloc__)
+#else
+    #define CBQ_ARGS_POOLED(QUEUE) \
+        0
+#endif // CBQ_ARGS_POOL
+
 void CBQ_containersSwapping__(MAY_REG CBQContainer_t*, MAY_REG CBQContainer_t*, MAY_REG size_t, const int);
 void CBQ_containersCopy__(MAY_REG const CBQContainer_t *restrict, MAY_REG CBQContainer_t *restrict, MAY_REG size_t);
-int CBQ_containersRangeInit__(CBQContainer_t*, unsigned int, size_t, const int);
-void CBQ_containersRangeFree__(MAY_REG CBQContainer_t*, MAY_REG size_t);
-int CBQ_changeArgsCapacity__(CBQContainer_t*, unsigned int, const int);
+int CBQ_containersRangeInit__(CBQueue_t*, CBQContainer_t*, unsigned int, size_t, const int);
+void CBQ_containersRangeFree__(CBQueue_t*, MAY_REG CBQContainer_t*, MAY_REG size_t);
+#ifdef CBQ_LAZY_INIT
+int CBQ_containerLazyInit__(CBQueue_t*, CBQContainer_t*);
+#endif // CBQ_LAZY_INIT
+int CBQ_changeArgsCapacity__(CBQueue_t*, CBQContainer_t*, unsigned int, const int);
 void CBQ_copyArgs__(MAY_REG const CBQArg_t *restrict, MAY_REG CBQArg_t *restrict, MAY_REG unsigned int);
 
+void* CBQ_defAlloc__(void*, size_t);
+void* CBQ_defResize__(void*, void*, size_t, size_t);
+void CBQ_defRelease__(void*, void*, size_t);
+void* CBQ_defAllocZeroed__(void*, size_t);
+void* CBQ_allocZeroed__(CBQueue_t*, size_t);
+
+CBQArg_t* CBQ_heapArgsAlloc__(CBQueue_t*, unsigned int);
+void CBQ_heapArgsFree__(CBQueue_t*, CBQArg_t*, unsigned int);
+
+int CBQ_argArenaReserve__(CBQueue_t*, size_t);
+CBQArg_t* CBQ_argArenaTake__(CBQueue_t*);
+void CBQ_argArenaPut__(CBQueue_t*, CBQArg_t*);
+void CBQ_argArenaFree__(CBQueue_t*);
+
+int CBQ_storageInit__(CBQueue_t*, size_t);
+void CBQ_storageFree__(CBQueue_t*);
+int CBQ_storageCopy__(CBQueue_t *restrict, const CBQueue_t *restrict);
+
+#ifdef CBQ_CHUNKED_STORAGE
+int CBQ_containersBlocksInit__(CBQueue_t*, CBQContainer_t**, size_t);
+void CBQ_containersBlocksFree__(CBQueue_t*, CBQContainer_t**, size_t);
+#endif // CBQ_CHUNKED_STORAGE
+
 
 #endif // CBQCONTAINER_H
@@ -34,15 +34,15 @@ void CBQ_drawScheme__(CBQueue_t* trustedQueue)
     for (size_t i = 0; i < trustedQueue->capacity; i++) {
 
         #ifdef __unix__
-            if (i == trustedQueue->rId && i == trustedQueue->sId)
+            if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->rId) && i == CBQ_CELL_ID(trustedQueue, trustedQueue->sId))
                 printf("\033[35m");
-            else if (i == trustedQueue->rId)
+            else if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->rId))
                 printf("\033[31m");
-            else if (i == trustedQueue->sId)
+            else if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->sId))
                 printf("\033[34m");
         #endif
 
-        cbqc = &trustedQueue->coArr[i];
+        cbqc = CBQ_CO_AT(trustedQueue, i);
 
         if (cbqc->label >= 'A' && cbqc->label <= 'Z')
             printf("%c", (char) cbqc->label);
@@ -58,11 +58,11 @@ void CBQ_drawScheme__(CBQueue_t* trustedQueue)
 
     #ifndef __unix__
         for (size_t i = 0; i < trustedQueue->capacity; i++) {
-            if (i == trustedQueue->rId && i == trustedQueue->sId)
+            if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->rId) && i == CBQ_CELL_ID(trustedQueue, trustedQueue->sId))
                 printf("b");
-            else if (i == trustedQueue->rId)
+            else if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->rId))
                 printf("r");
-            else if (i == trustedQueue->sId)
+            else if (i == CBQ_CELL_ID(trustedQueue, trustedQueue->sId))
                 printf("s");
             else
                 printf(".");
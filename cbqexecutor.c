@@ -0,0 +1,323 @@
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqexecutor.h"
+#include "cbqlocal.h"
+#ifdef CBQ_ARGS_POOL
+#include "cbqpool.h"
+#endif // CBQ_ARGS_POOL
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error Executor needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+struct CBQExecutorWorker_t {
+    CBQExecutor_t*  executor;
+    pthread_t       thread;
+    size_t          nextQueue;
+};
+
+static int CBQ_executorExecQueue__(CBQExecutor_t* executor, CBQExecutorQueue_t* exQueue);
+static int CBQ_executorHaveCalls__(CBQExecutor_t* executor);
+static void CBQ_executorPark__(CBQExecutor_t* executor);
+static void* CBQ_executorWorker__(void* arg);
+
+int CBQ_ExecutorInit(CBQExecutor_t* executor, unsigned int threadsCount, unsigned int spinCount, unsigned int parkTimeout,
+                     CBQErrHook errHook, void* hookCtx)
+{
+    pthread_condattr_t condAttr;
+
+    if (executor == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (executor->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    if (!threadsCount || threadsCount > CBQ_EXECUTOR_MAX_THREADS)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    executor->state = CBQ_EXS_IDLE;
+    executor->threadsCount = threadsCount;
+    executor->spinCount = spinCount;
+    executor->parkTimeout = parkTimeout;
+    executor->errHook = errHook;
+    executor->hookCtx = hookCtx;
+    executor->queuesCount = 0;
+    executor->workers = NULL;
+    executor->parked = 0;
+
+    if (pthread_mutex_init(&executor->parkLock, NULL))
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    /* park timeout is not affected by system time changes */
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&executor->parkCond, &condAttr)) {
+        pthread_condattr_destroy(&condAttr);
+        pthread_mutex_destroy(&executor->parkLock);
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+    pthread_condattr_destroy(&condAttr);
+
+    executor->initSt = CBQ_IN_INITED;
+
+    CBQ_MSGPRINT("Executor initialized");
+    return 0;
+}
+
+int CBQ_ExecutorFree(CBQExecutor_t* executor)
+{
+    BASE_ERR_CHECK(executor);
+
+    if (executor->state != CBQ_EXS_IDLE)
+        return CBQ_ERR_IS_BUSY;
+
+    pthread_cond_destroy(&executor->parkCond);
+    pthread_mutex_destroy(&executor->parkLock);
+    executor->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("Executor freed");
+    return 0;
+}
+
+int CBQ_ExecutorAddQueue(CBQExecutor_t* executor, CBQ_ExecutorQueueTypes type, void* queue)
+{
+    CBQExecutorQueue_t* exQueue;
+
+    BASE_ERR_CHECK(executor);
+
+    if (queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (type < CBQ_EXQ_QUEUE || type > CBQ_EXQ_MPMC || executor->queuesCount == CBQ_EXECUTOR_MAX_QUEUES)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    if (executor->state != CBQ_EXS_IDLE)
+        return CBQ_ERR_IS_BUSY;
+
+    exQueue = executor->queues + executor->queuesCount++;
+    exQueue->queue = queue;
+    exQueue->type = type;
+    exQueue->claimed = 0;
+
+    return 0;
+}
+
+int CBQ_ExecutorStart(CBQExecutor_t* executor)
+{
+    unsigned int i;
+
+    BASE_ERR_CHECK(executor);
+
+    if (executor->state != CBQ_EXS_IDLE)
+        return CBQ_ERR_IS_BUSY;
+
+    executor->workers = (CBQExecutorWorker_t*) CBQ_MALLOC(sizeof(CBQExecutorWorker_t) * executor->threadsCount);
+    if (executor->workers == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    CBQ_STORE_REL(&executor->state, CBQ_EXS_RUN);
+
+    for (i = 0; i < executor->threadsCount; i++) {
+        executor->workers[i].executor = executor;
+        executor->workers[i].nextQueue = executor->queuesCount? i % executor->queuesCount : 0;
+
+        if (pthread_create(&executor->workers[i].thread, NULL, CBQ_executorWorker__, executor->workers + i)) {
+            /* stop already started workers */
+            const unsigned int threadsCount = executor->threadsCount;
+
+            executor->threadsCount = i;
+            CBQ_ExecutorStop(executor, 0);
+            executor->threadsCount = threadsCount;
+            return CBQ_ERR_THREAD_START_FAILED;
+        }
+    }
+
+    CBQ_MSGPRINT("Executor started");
+    return 0;
+}
+
+/* Producers side: wakes one parked worker (cheap, when nobody is parked) */
+int CBQ_ExecutorNotify(CBQExecutor_t* executor)
+{
+    OPT_BASE_ERR_CHECK(executor);
+
+    /* pairs with fence of parking worker: either it sees pushed call, or notify sees it parked */
+    CBQ_FENCE();
+    if (CBQ_LOAD_RLX(&executor->parked)) {
+        pthread_mutex_lock(&executor->parkLock);
+        pthread_cond_signal(&executor->parkCond);
+        pthread_mutex_unlock(&executor->parkLock);
+    }
+
+    return 0;
+}
+
+int CBQ_ExecutorStop(CBQExecutor_t* executor, const int drain)
+{
+    unsigned int i;
+
+    BASE_ERR_CHECK(executor);
+
+    if (executor->state == CBQ_EXS_IDLE)
+        return 0;
+
+    for (i = 0; i < executor->threadsCount; i++)
+        if (pthread_equal(executor->workers[i].thread, pthread_self()))
+            return CBQ_ERR_IS_BUSY;
+
+    pthread_mutex_lock(&executor->parkLock);
+    CBQ_STORE_REL(&executor->state, drain? CBQ_EXS_DRAIN : CBQ_EXS_STOP);
+    pthread_cond_broadcast(&executor->parkCond);
+    pthread_mutex_unlock(&executor->parkLock);
+
+    for (i = 0; i < executor->threadsCount; i++)
+        pthread_join(executor->workers[i].thread, NULL);
+
+    CBQ_MEMFREE(executor->workers);
+    executor->workers = NULL;
+    executor->state = CBQ_EXS_IDLE;
+
+    CBQ_MSGPRINT("Executor stopped");
+    return 0;
+}
+
+/* ---------------- Workers ---------------- */
+/* Returns 1, when call was executed */
+static int CBQ_executorExecQueue__(CBQExecutor_t* executor, CBQExecutorQueue_t* exQueue)
+{
+    int errSt, retSt = 0, claimed = 0;
+
+    if (exQueue->type != CBQ_EXQ_MPMC && !CBQ_CAS_ACQ(&exQueue->claimed, &claimed, 1))
+        return 0;   // other worker is consumer now
+
+    switch (exQueue->type) {
+    case CBQ_EXQ_QUEUE:
+        errSt = CBQ_HAVECALL_P( (CBQueue_t*) exQueue->queue)? CBQ_Exec( (CBQueue_t*) exQueue->queue, &retSt) : CBQ_ERR_QUEUE_IS_EMPTY;
+        break;
+    case CBQ_EXQ_SPSC:
+        errSt = CBQ_SpscExec( (CBQSpscQueue_t*) exQueue->queue, &retSt);
+        break;
+    case CBQ_EXQ_MPSC:
+        errSt = CBQ_MpscExec( (CBQMpscQueue_t*) exQueue->queue, &retSt);
+        break;
+    default:
+        errSt = CBQ_MpmcExec( (CBQMpmcQueue_t*) exQueue->queue, &retSt);
+    }
+
+    if (exQueue->type != CBQ_EXQ_MPMC)
+        CBQ_STORE_REL(&exQueue->claimed, 0);
+
+    if (errSt)
+        return 0;
+
+    if (retSt && executor->errHook != NULL)
+        executor->errHook(executor->hookCtx, exQueue->queue, retSt);
+
+    return 1;
+}
+
+static int CBQ_executorHaveCalls__(CBQExecutor_t* executor)
+{
+    CBQExecutorQueue_t* exQueue;
+    size_t i, size;
+    int claimed;
+
+    for (i = 0; i < executor->queuesCount; i++) {
+        exQueue = executor->queues + i;
+
+        switch (exQueue->type) {
+        case CBQ_EXQ_QUEUE:
+            /* base queue is only read by its consumer */
+            claimed = 0;
+            if (!CBQ_CAS_ACQ(&exQueue->claimed, &claimed, 1))
+                return 1;
+            size = CBQ_HAVECALL_P( (CBQueue_t*) exQueue->queue);
+            CBQ_STORE_REL(&exQueue->claimed, 0);
+            break;
+        case CBQ_EXQ_SPSC:
+            CBQ_SpscGetSize( (CBQSpscQueue_t*) exQueue->queue, &size);
+            break;
+        case CBQ_EXQ_MPSC:
+            CBQ_MpscGetSize( (CBQMpscQueue_t*) exQueue->queue, &size);
+            break;
+        default:
+            CBQ_MpmcGetSize( (CBQMpmcQueue_t*) exQueue->queue, &size);
+        }
+
+        if (size)
+            return 1;
+    }
+
+    return 0;
+}
+
+static void CBQ_executorPark__(CBQExecutor_t* executor)
+{
+    struct timespec deadline;
+
+    pthread_mutex_lock(&executor->parkLock);
+    CBQ_FETCH_ADD(&executor->parked, 1);
+    CBQ_FENCE();
+
+    /* calls could be pushed before worker was counted as parked */
+    if (CBQ_LOAD_ACQ(&executor->state) == CBQ_EXS_RUN && !CBQ_executorHaveCalls__(executor)) {
+        if (executor->parkTimeout) {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += executor->parkTimeout / 1000;
+            deadline.tv_nsec += (long) (executor->parkTimeout % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&executor->parkCond, &executor->parkLock, &deadline);
+        } else
+            pthread_cond_wait(&executor->parkCond, &executor->parkLock);
+    }
+
+    CBQ_FETCH_SUB(&executor->parked, 1);
+    pthread_mutex_unlock(&executor->parkLock);
+}
+
+static void* CBQ_executorWorker__(void* arg)
+{
+    CBQExecutorWorker_t* worker = (CBQExecutorWorker_t*) arg;
+    CBQExecutor_t* executor = worker->executor;
+    unsigned int idleSpins = 0;
+    size_t i, queueId;
+    int state, executed;
+
+    for (;;) {
+        /* one turn over all queues from the next one after last executed */
+        executed = 0;
+        for (i = 0; i < executor->queuesCount && !executed; i++) {
+            queueId = (worker->nextQueue + i) % executor->queuesCount;
+            if (CBQ_executorExecQueue__(executor, executor->queues + queueId)) {
+                worker->nextQueue = (queueId + 1) % executor->queuesCount;
+                executed = 1;
+            }
+        }
+
+        if (executed) {
+            idleSpins = 0;
+            continue;
+        }
+
+        state = CBQ_LOAD_ACQ(&executor->state);
+        if (state == CBQ_EXS_STOP || (state == CBQ_EXS_DRAIN && !CBQ_executorHaveCalls__(executor)))
+            break;
+
+        if (idleSpins < executor->spinCount) {
+            idleSpins++;
+            CBQ_CPU_RELAX();
+        } else {
+            CBQ_executorPark__(executor);
+            idleSpins = 0;
+        }
+    }
+
+    #ifdef CBQ_ARGS_POOL
+    CBQ_ArgsPoolClear();
+    #endif // CBQ_ARGS_POOL
+
+    return NULL;
+}
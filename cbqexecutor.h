@@ -0,0 +1,100 @@
+#ifndef CBQEXECUTOR_H
+#define CBQEXECUTOR_H
+
+#include <pthread.h>
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+#include "cbqspsc.h"
+#include "cbqmpsc.h"
+#include "cbqmpmc.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Max queues which are drained by one executor and max worker threads (may be set in cbqbuildconf.h) */
+    #ifndef CBQ_EXECUTOR_MAX_QUEUES
+        #define CBQ_EXECUTOR_MAX_QUEUES 8
+    #endif
+    #ifndef CBQ_EXECUTOR_MAX_THREADS
+        #define CBQ_EXECUTOR_MAX_THREADS 256
+    #endif
+
+    /* Types of queues, which could be added into executor:
+     * CBQ_EXQ_QUEUE - base queue, it is executed by one worker at once and must be pushed
+     *  only from own callbacks or while executor is stopped (base queue is not thread-safe);
+     * CBQ_EXQ_SPSC, CBQ_EXQ_MPSC - executed by one worker at once (executor is consumer);
+     * CBQ_EXQ_MPMC - executed by all workers at once.
+     */
+    typedef enum {
+        CBQ_EXQ_QUEUE,
+        CBQ_EXQ_SPSC,
+        CBQ_EXQ_MPSC,
+        CBQ_EXQ_MPMC
+    } CBQ_ExecutorQueueTypes;
+
+    /* Executor states */
+    enum CBQ_ExecutorStates {
+        CBQ_EXS_IDLE,
+        CBQ_EXS_RUN,
+        CBQ_EXS_DRAIN,
+        CBQ_EXS_STOP
+    };
+
+    /* Gets return statuses of callbacks which are not zero */
+    typedef void (*CBQErrHook)(void* hookCtx, void* queue, int funcRetSt);
+
+    typedef struct CBQExecutorQueue_t CBQExecutorQueue_t;
+    struct CBQExecutorQueue_t {
+        void*   queue;
+        int     type;
+        int     claimed;    // consumer lock of single consumer queues
+    };
+
+    typedef struct CBQExecutorWorker_t CBQExecutorWorker_t;
+
+    /* Thread-pool executor
+     * Owns worker threads, which execute calls of added queues (round-robin, one call of
+     * queue per turn). Idle worker spins spinCount times, then it parks until
+     * CBQ_ExecutorNotify (call it after push from other threads) or park timeout (in ms,
+     * 0 - without timeout). Queues are added before start. Stop with drain lets workers
+     * execute all calls of queues (including pushed by callbacks) before exit.
+     */
+    typedef struct CBQExecutor_t CBQExecutor_t;
+    struct CBQExecutor_t {
+        int initSt;
+        int state;
+
+        unsigned int    threadsCount;
+        unsigned int    spinCount;
+        unsigned int    parkTimeout;
+        CBQErrHook      errHook;
+        void*           hookCtx;
+
+        CBQExecutorQueue_t  queues[CBQ_EXECUTOR_MAX_QUEUES];
+        size_t              queuesCount;
+
+        CBQExecutorWorker_t* workers;
+
+        /* parking of idle workers */
+        int             parked;
+        pthread_mutex_t parkLock;
+        pthread_cond_t  parkCond;
+    };
+
+int CBQ_ExecutorInit(CBQExecutor_t* executor, unsigned int threadsCount, unsigned int spinCount, unsigned int parkTimeout,
+                     CBQErrHook errHook, void* hookCtx);
+int CBQ_ExecutorFree(CBQExecutor_t* executor);
+
+int CBQ_ExecutorAddQueue(CBQExecutor_t* executor, CBQ_ExecutorQueueTypes type, void* queue);
+
+int CBQ_ExecutorStart(CBQExecutor_t* executor);
+int CBQ_ExecutorNotify(CBQExecutor_t* executor);
+/* Waits for workers, must not be called from callbacks of executor */
+int CBQ_ExecutorStop(CBQExecutor_t* executor, const int drain);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQEXECUTOR_H
@@ -7,7 +7,12 @@
 
 // Limits and inits values:
 
-    #define CBQ_QUEUE_MAX_CAPACITY  (SIZE_MAX >> 1)
+    #ifndef CBQ_POW2_CAPACITY
+        #define CBQ_QUEUE_MAX_CAPACITY  (SIZE_MAX >> 1)
+    #else
+        /* greatest power of two capacity */
+        #define CBQ_QUEUE_MAX_CAPACITY  ((SIZE_MAX >> 2) + 1)
+    #endif // CBQ_POW2_CAPACITY
     /* init capacites written in cbqueue.h */
     #define CBQ_QUEUE_MIN_CAPACITY  1
 
@@ -19,6 +24,32 @@
     #define INIT_CAP_ARGS       5
     #define MAX_CAP_ARGS        20
 
+    /* Inline args area of container (may be set in cbqbuildconf.h) */
+    #ifndef CBQ_INLINE_ARGS
+        #define CBQ_INLINE_ARGS     INIT_CAP_ARGS
+    #endif
+
+    #if CBQ_INLINE_ARGS < MIN_CAP_ARGS || CBQ_INLINE_ARGS > MAX_CAP_ARGS
+        #error CBQ_INLINE_ARGS is out of args capacity range
+    #endif
+
+    /* Containers block capacity of chunked storage (may be set in cbqbuildconf.h) */
+    #ifdef CBQ_CHUNKED_STORAGE
+
+        #ifndef CBQ_CHUNK_CAPACITY
+            #define CBQ_CHUNK_CAPACITY  64
+        #endif
+
+        #if CBQ_CHUNK_CAPACITY < 1 || (CBQ_CHUNK_CAPACITY & (CBQ_CHUNK_CAPACITY - 1))
+            #error CBQ_CHUNK_CAPACITY must be a power of two
+        #endif
+
+        #ifdef CBQ_POW2_CAPACITY
+            #error CBQ_CHUNKED_STORAGE cannot be used with CBQ_POW2_CAPACITY
+        #endif
+
+    #endif // CBQ_CHUNKED_STORAGE
+
     /* Queue init status types */
     enum {
         CBQ_IN_INITED = 0x51494E49,
@@ -32,6 +63,12 @@
         CBQ_ST_FULL
     };
 
+    /* Storage types of spilled container args */
+    enum {
+        CBQ_AST_HEAP,
+        CBQ_AST_ARENA
+    };
+
     /* Executing status */
     enum {
         CBQ_EST_NO_EXEC,
@@ -43,6 +80,8 @@
 
         #define CBQ_MALLOC(capacity) \
             malloc(capacity)
+        #define CBQ_CALLOC(capacity) \
+            calloc(1, capacity)
         #define CBQ_REALLOC(pointer, capacity) \
             realloc(pointer, capacity)
         #define CBQ_MEMFREE(pointer) \
@@ -52,22 +91,231 @@
         #error Unknown choosed mem alloc methods
     #endif
 
-    #define CBQ_TIMER_METHODS 1
-    #if CBQ_TIMER_METHODS == 1    // POSIX
-        #include <time.h>
+    /* Thread local storage (args pool, current worker of scheduler) */
+    #if defined(__GNUC__)
+        #define CBQ_THREAD_LOCAL __thread
+    #elif defined(_MSC_VER)
+        #define CBQ_THREAD_LOCAL __declspec(thread)
+    #endif
+
+    /* Args pool config: max cached buffers in each capacity class (may be set in cbqbuildconf.h) */
+    #ifdef CBQ_ARGS_POOL
+        #ifndef CBQ_ARGS_POOL_CLASS_LIMIT
+            #define CBQ_ARGS_POOL_CLASS_LIMIT 32
+        #endif
+
+        #ifndef CBQ_THREAD_LOCAL
+            #define CBQ_THREAD_LOCAL    // one pool for all threads
+        #endif
+    #endif // CBQ_ARGS_POOL
+
+    /* Memory methods of queue allocator (CBQ_MALLOC methods by default) */
+    #define CBQ_QMALLOC(QUEUE, SIZE) \
+        (QUEUE)->allocator.alloc((QUEUE)->allocator.ctx, SIZE)
+    #define CBQ_QREALLOC(QUEUE, POINTER, OLD_SIZE, NEW_SIZE) \
+        (QUEUE)->allocator.resize((QUEUE)->allocator.ctx, POINTER, OLD_SIZE, NEW_SIZE)
+    #define CBQ_QMEMFREE(QUEUE, POINTER, SIZE) \
+        (QUEUE)->allocator.release((QUEUE)->allocator.ctx, POINTER, SIZE)
+
+    /* Atomic access to ids of concurrent queues (GCC/Clang builtins) */
+    #if defined(__GNUC__)
+
+        #define CBQ_ATOMIC_METHODS
 
+        #define CBQ_LOAD_RLX(POINTER) \
+            __atomic_load_n(POINTER, __ATOMIC_RELAXED)
+        #define CBQ_LOAD_ACQ(POINTER) \
+            __atomic_load_n(POINTER, __ATOMIC_ACQUIRE)
+        #define CBQ_STORE_REL(POINTER, VALUE) \
+            __atomic_store_n(POINTER, VALUE, __ATOMIC_RELEASE)
+        /* on failure expected value is updated by current one */
+        #define CBQ_CAS_RLX(POINTER, EXPECTED_POINTER, VALUE) \
+            __atomic_compare_exchange_n(POINTER, EXPECTED_POINTER, VALUE, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+        #define CBQ_CAS_ACQ(POINTER, EXPECTED_POINTER, VALUE) \
+            __atomic_compare_exchange_n(POINTER, EXPECTED_POINTER, VALUE, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+        /* sequentially consistent (sleep/wake handshakes) */
+        #define CBQ_FETCH_ADD(POINTER, VALUE) \
+            __atomic_fetch_add(POINTER, VALUE, __ATOMIC_SEQ_CST)
+        #define CBQ_FETCH_SUB(POINTER, VALUE) \
+            __atomic_fetch_sub(POINTER, VALUE, __ATOMIC_SEQ_CST)
+        #define CBQ_FENCE() \
+            __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+        /* hint for spin-wait loops */
+        #if defined(__i386__) || defined(__x86_64__)
+            #define CBQ_CPU_RELAX() \
+                __builtin_ia32_pause()
+        #elif defined(__aarch64__) || defined(__arm__)
+            #define CBQ_CPU_RELAX() \
+                __asm__ __volatile__ ("yield")
+        #else
+            #define CBQ_CPU_RELAX() \
+                ((void) 0)
+        #endif
+
+    #endif // __GNUC__
+
+    /* Calls of time-budgeted exec between clock reads (may be set in cbqbuildconf.h) */
+    #ifndef CBQ_EXEC_FOR_CHECK_STEP
+        #define CBQ_EXEC_FOR_CHECK_STEP 16
+    #endif
+
+    #if CBQ_EXEC_FOR_CHECK_STEP < 1
+        #error CBQ_EXEC_FOR_CHECK_STEP must be positive
+    #endif
+
+    /* Read prefetch hint (next containers and args of batched exec) */
+    #if defined(__GNUC__)
+        #define CBQ_PREFETCH(POINTER) \
+            __builtin_prefetch(POINTER, 0, 3)
+    #else
+        #define CBQ_PREFETCH(POINTER) \
+            ((void) 0)
+    #endif // __GNUC__
+
+    /* Timer methods (may be set in cbqbuildconf.h).
+     * CBQ_CURTICKS is read by timer checks (SetTimeout frame calls, wheel advance, auto shrink),
+     * CBQ_FRESHTICKS is read when deadline is set, CBQ_REFRESHTICKS is done once per exec call or batch.
+     */
+    #ifndef CBQ_TIMER_METHODS
+        #define CBQ_TIMER_METHODS 2
+    #endif
+
+    #include <time.h>
+
+    /* Timer ticks are 64-bit with any methods (deadlines of SetTimeout are kept in lliVar) */
+    typedef long long CBQTicks_t;
+
+    unsigned long long CBQ_monotonicNs__(void);
+
+    #if CBQ_TIMER_METHODS == 1    // clock(), processor time
         #define CBQ_CURTICKS() \
             ((CBQTicks_t)clock())
 
+        #define CBQ_FRESHTICKS() \
+            CBQ_CURTICKS()
+
+        #define CBQ_REFRESHTICKS() \
+            ((void) 0)
+
         #define CBQ_TIC_P_SEC \
-            CLOCKS_PER_SEC
+            ((CBQTicks_t)CLOCKS_PER_SEC)
+
+    #elif CBQ_TIMER_METHODS == 2    // monotonic clock, ticks are ns
+        #define CBQ_CURTICKS() \
+            ((CBQTicks_t)CBQ_monotonicNs__())
 
-        typedef clock_t CBQTicks_t;
+        #define CBQ_FRESHTICKS() \
+            CBQ_CURTICKS()
+
+        #define CBQ_REFRESHTICKS() \
+            ((void) 0)
+
+        #define CBQ_TIC_P_SEC \
+            1000000000LL
+
+    #elif CBQ_TIMER_METHODS == 3    // cached coarse monotonic clock, ticks are ns
+        #if defined(__GNUC__)
+            #define CBQ_THREAD_LOCAL __thread
+        #elif defined(_MSC_VER)
+            #define CBQ_THREAD_LOCAL __declspec(thread)
+        #else
+            #define CBQ_THREAD_LOCAL _Thread_local
+        #endif
+
+        /* Time of last refresh in thread (each consumer refreshes it by its exec methods) */
+        extern CBQ_THREAD_LOCAL CBQTicks_t CBQ_cachedTicks__;
+
+        unsigned long long CBQ_coarseNs__(void);
+
+        #define CBQ_CURTICKS() \
+            CBQ_cachedTicks__
+
+        #define CBQ_FRESHTICKS() \
+            (CBQ_cachedTicks__ = (CBQTicks_t)CBQ_coarseNs__())
+
+        #define CBQ_REFRESHTICKS() \
+            ((void) CBQ_FRESHTICKS())
+
+        #define CBQ_TIC_P_SEC \
+            1000000000LL
 
     #else // CBQ_TIMER_METHODS
         #error Unknown choosed timer methods
     #endif
 
+    /* Conversions of clock() ticks (CLOCKS_PER_SEC) and ns into timer ticks and back.
+     * ns are rounded up into ticks, so deadline is never earlier than delay.
+     */
+    #define CBQ_CLOCK_TO_TICKS(CLOCKS) \
+        ((CBQTicks_t)(CLOCKS) * (CBQ_TIC_P_SEC / (CBQTicks_t)CLOCKS_PER_SEC))
+
+    #define CBQ_NS_P_TIC \
+        (1000000000ULL / (unsigned long long)CBQ_TIC_P_SEC)
+
+    #define CBQ_NS_TO_TICKS(NS) \
+        ((CBQTicks_t)(((NS) + CBQ_NS_P_TIC - 1) / CBQ_NS_P_TIC))
+
+    #define CBQ_TICKS_TO_NS(TICKS) \
+        ((unsigned long long)(TICKS) * CBQ_NS_P_TIC)
+
+    /* Read and store ids (rId, sId) of queue.
+     * With power of two capacity ids are free-running counters: cell is taken by mask,
+     * size is difference of ids and full queue check is subtraction.
+     * Otherwise ids are cell indexes, which are wrapped on capacity edge.
+     */
+    #ifdef CBQ_POW2_CAPACITY
+
+        #define CBQ_CELL_ID(QUEUE, ID) \
+            ((ID) & ((QUEUE)->capacity - 1))
+
+        #define CBQ_NEXT_ID(QUEUE, ID) \
+            ((ID) + 1)
+
+        #define CBQ_ADD_ID(QUEUE, ID, COUNT) \
+            ((ID) + (COUNT))
+
+        #define CBQ_PREV_ID(QUEUE, ID) \
+            ((ID) - 1)
+
+        #define CBQ_STORED_STATUS(QUEUE) \
+            ((QUEUE)->sId - (QUEUE)->rId == (QUEUE)->capacity? CBQ_ST_FULL : CBQ_ST_STABLE)
+
+    #else // CBQ_POW2_CAPACITY
+
+        #define CBQ_CELL_ID(QUEUE, ID) \
+            (ID)
+
+        #define CBQ_NEXT_ID(QUEUE, ID) \
+            ((ID) + 1 < (QUEUE)->capacity? (ID) + 1 : 0)
+
+        #define CBQ_ADD_ID(QUEUE, ID, COUNT) \
+            (((ID) + (COUNT)) % (QUEUE)->capacity)
+
+        #define CBQ_PREV_ID(QUEUE, ID) \
+            ((ID)? (ID) - 1 : (QUEUE)->capacity - 1)
+
+        #define CBQ_STORED_STATUS(QUEUE) \
+            ((QUEUE)->sId == (QUEUE)->rId? CBQ_ST_FULL : CBQ_ST_STABLE)
+
+    #endif // CBQ_POW2_CAPACITY
+
+    /* status after read (the same for both id types) */
+    #define CBQ_READ_STATUS(QUEUE) \
+        ((QUEUE)->rId == (QUEUE)->sId? CBQ_ST_EMPTY : CBQ_ST_STABLE)
+
+    /* Container of queue cell (by cell index or by id) */
+    #ifndef CBQ_CHUNKED_STORAGE
+        #define CBQ_CO_AT(QUEUE, CELL) \
+            ((QUEUE)->coArr + (CELL))
+    #else
+        #define CBQ_CO_AT(QUEUE, CELL) \
+            ((QUEUE)->coBlocks[(CELL) / CBQ_CHUNK_CAPACITY] + (CELL) % CBQ_CHUNK_CAPACITY)
+    #endif // CBQ_CHUNKED_STORAGE
+
+    #define CBQ_CO_BY_ID(QUEUE, ID) \
+        CBQ_CO_AT(QUEUE, CBQ_CELL_ID(QUEUE, ID))
+
     #define SWAP_BY_TEMP(A, B, TEMP) \
     TEMP = B; \
     B = A; \
@@ -90,6 +338,18 @@
 
     enum { ST_QUEUE, ST_DELAY, ST_TRG_QUEUE, ST_FUNC };
 
+    /* SetInterval frame has period and policy after SetTimeout args */
+    #define IN_ARG_C    (ST_ARG_C + 2)
+
+    enum { IN_PERIOD = ST_ARG_C, IN_POLICY };
+
+    /* Next deadline of periodic call is anchored to the first one (no drift),
+     * CBQ_IP_SKIP moves it over missed periods to the first one after NOW
+     */
+    #define CBQ_NEXT_DEADLINE(DEADLINE, PERIOD, POLICY, NOW) \
+        ((DEADLINE) + (PERIOD) + ((POLICY) == CBQ_IP_SKIP && (DEADLINE) + (PERIOD) <= (NOW)? \
+            ((NOW) - (DEADLINE) - (PERIOD)) / (PERIOD) * (PERIOD) + (PERIOD) : 0))
+
     /* storing 64 bit value in register */
     #ifdef REG_CYCLE_VARS
         #define MAY_REG register
@@ -0,0 +1,166 @@
+#include <stddef.h>
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqmpmc.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error MPMC queue needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+int CBQ_MpmcQueueInit(CBQMpmcQueue_t* queue, size_t capacity, const CBQAllocator_t* allocator)
+{
+    int errSt;
+    CBQMpmcQueue_t iniQueue = {
+        .base = {0},
+        .rId = 0,
+        .sId = 0
+    };
+
+    if (queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    errSt = CBQ_seqSlotsInit__(&iniQueue.base, &iniQueue.seqs, capacity, allocator);
+    if (errSt)
+        return errSt;
+
+    iniQueue.mask = iniQueue.base.capacity - 1;
+
+    iniQueue.initSt = CBQ_IN_INITED;
+    *queue = iniQueue;
+
+    CBQ_MSGPRINT("MPMC queue initialized");
+    return 0;
+}
+
+/* All threads must be stopped */
+int CBQ_MpmcQueueFree(CBQMpmcQueue_t* queue)
+{
+    BASE_ERR_CHECK(queue);
+
+    CBQ_seqSlotsFree__(&queue->base, queue->seqs);
+    queue->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("MPMC queue freed");
+    return 0;
+}
+
+/* ---------------- Producers Methods ---------------- */
+int CBQ_MpmcPush(CBQMpmcQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (varParams == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!varParamc)
+        return CBQ_ERR_VPARAM_VARIANCE;
+    #endif
+
+    errSt = CBQ_seqSlotsStore__(&queue->base, queue->seqs, &queue->sId, func, varParamc, varParams);
+
+    /* call with failed args is published too */
+    if (errSt != CBQ_ERR_STATIC_CAPACITY_OVERFLOW)
+        CBQ_notifyWaiter__(&queue->waitState);
+
+    return errSt;
+}
+
+int CBQ_MpmcPushVoid(CBQMpmcQueue_t* queue, QCallback func)
+{
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    errSt = CBQ_seqSlotsStore__(&queue->base, queue->seqs, &queue->sId, func, 0, NULL);
+    if (!errSt)
+        CBQ_notifyWaiter__(&queue->waitState);
+
+    return errSt;
+}
+
+/* ---------------- Consumers Methods ---------------- */
+int CBQ_MpmcExec(CBQMpmcQueue_t* queue, int* funcRetSt)
+{
+    CBQContainer_t* container;
+    CBQContainer_t call;
+    size_t rId, seq;
+    int retSt = 0;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    /* claim slot */
+    rId = CBQ_LOAD_RLX(&queue->rId);
+    for (;;) {
+        seq = CBQ_LOAD_ACQ(queue->seqs + (rId & queue->mask));
+
+        if (seq == rId + 1) {
+            if (CBQ_CAS_RLX(&queue->rId, &rId, rId + 1))
+                break;
+        } else if ((ptrdiff_t) (seq - (rId + 1)) < 0)
+            return CBQ_ERR_QUEUE_IS_EMPTY;  // slot is not published yet
+        else
+            rId = CBQ_LOAD_RLX(&queue->rId);    // slot is claimed by other consumer
+    }
+
+    /* move call out of slot, spilled args are taken by ownership */
+    container = CBQ_CO_AT(&queue->base, rId & queue->mask);
+    call.func = container->func;
+    call.argc = container->argc;
+    call.capacity = container->capacity;
+
+    if (CBQ_CO_IS_INLINE(container)) {
+        if (call.argc)
+            CBQ_copyArgs__(container->args.inl, call.args.inl, call.argc);
+    } else {
+        call.args.ext = container->args.ext;
+        container->capacity = CBQ_INLINE_ARGS;
+    }
+
+    CBQ_STORE_REL(queue->seqs + (rId & queue->mask), rId + queue->base.capacity);
+
+    if (call.func != NULL)
+        retSt = call.func( (int) call.argc, CBQ_CO_ARGS(&call));
+
+    /* spilled args are always heap ones (args arena of base queue is unused) */
+    if (!CBQ_CO_IS_INLINE(&call))
+        CBQ_heapArgsFree__(&queue->base, call.args.ext, call.capacity);
+
+    if (funcRetSt != NULL)
+        *funcRetSt = retSt;
+
+    return 0;
+}
+
+static int CBQ_mpmcExecMethod__(void* queue, int* funcRetSt)
+{
+    return CBQ_MpmcExec( (CBQMpmcQueue_t*) queue, funcRetSt);
+}
+
+int CBQ_MpmcExecWait(CBQMpmcQueue_t* queue, long timeout, int* funcRetSt)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    return CBQ_execWait__(queue, CBQ_mpmcExecMethod__, &queue->waitState, timeout, funcRetSt);
+}
+
+int CBQ_MpmcGetSize(const CBQMpmcQueue_t* queue, size_t* size)
+{
+    size_t rId, sId;
+
+    OPT_BASE_ERR_CHECK(queue);
+    if (size == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    rId = CBQ_LOAD_ACQ(&queue->rId);
+    sId = CBQ_LOAD_ACQ(&queue->sId);
+    *size = sId > rId? sId - rId : 0;
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CBQMPMC_H
+#define CBQMPMC_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+#include "cbqmpsc.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Multi-producer/multi-consumer queue
+     * Lock-free bounded queue for any number of pushing and executing threads
+     * (worker pools). Slots are the same as in MPSC queue, but consumers also claim
+     * slot by CAS on rId. Claimed call is moved out of its slot (spilled args by
+     * ownership) and slot is returned to producers before callback runs, so long
+     * callbacks do not hold up producers and exec may be called from callback.
+     * There is no busy status: exec returns CBQ_ERR_QUEUE_IS_EMPTY when no published
+     * call is left for this consumer.
+     * Capacity is rounded up to power of two and does not change (push into full queue
+     * returns CBQ_ERR_STATIC_CAPACITY_OVERFLOW).
+     */
+    typedef struct CBQMpmcQueue_t CBQMpmcQueue_t;
+    struct CBQMpmcQueue_t {
+
+        /* init status */
+        int     initSt;
+
+        /* containers storage and slots sequences (read only after init) */
+        CBQueue_t base;
+        size_t* seqs;
+        size_t  mask;
+        char    padBase[CBQ_CACHE_LINE_SIZE];
+
+        /* consumers side */
+        size_t  rId;
+        char    padConsumers[CBQ_CACHE_LINE_SIZE - sizeof(size_t)];
+
+        /* producers side */
+        size_t  sId;
+        char    padProducers[CBQ_CACHE_LINE_SIZE - sizeof(size_t)];
+
+        /* sleeping consumers (producers read it on every push) */
+        CBQWaitState_t waitState;
+        char    padWait[CBQ_CACHE_LINE_SIZE - sizeof(CBQWaitState_t)];
+    };
+
+int CBQ_MpmcQueueInit(CBQMpmcQueue_t* queue, size_t capacity, const CBQAllocator_t* allocator);
+int CBQ_MpmcQueueFree(CBQMpmcQueue_t* queue);
+
+/* producers methods */
+int CBQ_MpmcPush(CBQMpmcQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+int CBQ_MpmcPushVoid(CBQMpmcQueue_t* queue, QCallback func);
+
+/* consumers methods */
+int CBQ_MpmcExec(CBQMpmcQueue_t* queue, int* funcRetSt);
+/* sleeps until call is pushed or timeout (ms) is expired, each push wakes one consumer (see cbqwait.h) */
+int CBQ_MpmcExecWait(CBQMpmcQueue_t* queue, long timeout, int* funcRetSt);
+
+/* size may be outdated at once, if other threads work */
+int CBQ_MpmcGetSize(const CBQMpmcQueue_t* queue, size_t* size);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQMPMC_H
@@ -0,0 +1,248 @@
+#include <stddef.h>
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqmpsc.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+#include "cbqcapacity.h"
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error MPSC queue needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+#define MPSC_MAX_CAPACITY ((SIZE_MAX >> 2) + 1)
+
+/* ---------------- Sequenced Slots (shared with MPMC queue) ---------------- */
+/* Slot sequence states for position (free-running id) POS:
+ * POS - slot is free for producer of POS,
+ * POS + 1 - call of POS is published for consumers,
+ * POS + capacity - slot is free for next round.
+ */
+int CBQ_seqSlotsInit__(CBQueue_t* base, size_t** seqs, size_t capacity, const CBQAllocator_t* allocator)
+{
+    int errSt;
+    size_t i;
+
+    if (capacity < CBQ_QUEUE_MIN_CAPACITY || capacity > MPSC_MAX_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    /* inline init args capacity keeps args arena of base queue unused (it is not shared by producers) */
+    errSt = CBQ_QueueInitWithAllocator(base, CBQ_roundUpPow2__(capacity), CBQ_SM_STATIC, 0, CBQ_INLINE_ARGS, allocator);
+    if (errSt)
+        return errSt;
+
+    *seqs = (size_t*) CBQ_QMALLOC(base, sizeof(size_t) * base->capacity);
+    if (*seqs == NULL) {
+        CBQ_QueueFree(base);
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+
+    for (i = 0; i < base->capacity; i++)
+        (*seqs)[i] = i;
+
+    return 0;
+}
+
+void CBQ_seqSlotsFree__(CBQueue_t* base, size_t* seqs)
+{
+    CBQ_QMEMFREE(base, seqs, sizeof(size_t) * base->capacity);
+    CBQ_QueueFree(base);
+}
+
+int CBQ_seqSlotsStore__(CBQueue_t* base, size_t* seqs, size_t* sIdP, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    CBQContainer_t* container;
+    const size_t mask = base->capacity - 1;
+    size_t sId = CBQ_LOAD_RLX(sIdP);
+    size_t seq;
+    int errSt;
+
+    /* claim slot */
+    for (;;) {
+        seq = CBQ_LOAD_ACQ(seqs + (sId & mask));
+
+        if (seq == sId) {
+            if (CBQ_CAS_RLX(sIdP, &sId, sId + 1))
+                break;
+        } else if ((ptrdiff_t) (seq - sId) < 0)
+            return CBQ_ERR_STATIC_CAPACITY_OVERFLOW;    // slot of previous round is not executed yet
+        else
+            sId = CBQ_LOAD_RLX(sIdP);   // slot is claimed by other producer
+    }
+
+    /* container is owned by producer until slot is published */
+    container = CBQ_CO_AT(base, sId & mask);
+
+    #ifdef CBQ_LAZY_INIT
+    if (CBQ_CO_IS_UNINITED(container))
+        container->capacity = CBQ_INLINE_ARGS;
+    #endif // CBQ_LAZY_INIT
+
+    errSt = 0;
+    if (varParamc > container->capacity)
+        errSt = CBQ_changeArgsCapacity__(base, container, varParamc, 0);
+
+    /* slot is already claimed, so failed call is published without func (exec of it does nothing) */
+    if (errSt) {
+        container->func = NULL;
+        container->argc = 0;
+    } else {
+        if (varParamc)
+            CBQ_copyArgs__(varParams, CBQ_CO_ARGS(container), varParamc);
+
+        container->argc = varParamc;
+        container->func = func;
+    }
+
+    CBQ_STORE_REL(seqs + (sId & mask), sId + 1);
+
+    return errSt;
+}
+
+/* ---------------- MPSC Queue ---------------- */
+int CBQ_MpscQueueInit(CBQMpscQueue_t* queue, size_t capacity, const CBQAllocator_t* allocator)
+{
+    int errSt;
+    CBQMpscQueue_t iniQueue = {
+        .base = {0},
+        .rId = 0,
+        .execSt = CBQ_EST_NO_EXEC,
+        .sId = 0
+    };
+
+    if (queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    errSt = CBQ_seqSlotsInit__(&iniQueue.base, &iniQueue.seqs, capacity, allocator);
+    if (errSt)
+        return errSt;
+
+    iniQueue.mask = iniQueue.base.capacity - 1;
+
+    iniQueue.initSt = CBQ_IN_INITED;
+    *queue = iniQueue;
+
+    CBQ_MSGPRINT("MPSC queue initialized");
+    return 0;
+}
+
+/* All sides must be stopped */
+int CBQ_MpscQueueFree(CBQMpscQueue_t* queue)
+{
+    BASE_ERR_CHECK(queue);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    CBQ_seqSlotsFree__(&queue->base, queue->seqs);
+    queue->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("MPSC queue freed");
+    return 0;
+}
+
+/* ---------------- Producers Methods ---------------- */
+int CBQ_MpscPush(CBQMpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (varParams == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!varParamc)
+        return CBQ_ERR_VPARAM_VARIANCE;
+    #endif
+
+    errSt = CBQ_seqSlotsStore__(&queue->base, queue->seqs, &queue->sId, func, varParamc, varParams);
+
+    /* call with failed args is published too */
+    if (errSt != CBQ_ERR_STATIC_CAPACITY_OVERFLOW)
+        CBQ_notifyWaiter__(&queue->waitState);
+
+    return errSt;
+}
+
+int CBQ_MpscPushVoid(CBQMpscQueue_t* queue, QCallback func)
+{
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    errSt = CBQ_seqSlotsStore__(&queue->base, queue->seqs, &queue->sId, func, 0, NULL);
+    if (!errSt)
+        CBQ_notifyWaiter__(&queue->waitState);
+
+    return errSt;
+}
+
+/* ---------------- Consumer Methods ---------------- */
+int CBQ_MpscExec(CBQMpscQueue_t* queue, int* funcRetSt)
+{
+    CBQContainer_t* container;
+    const size_t rId = queue->rId;  // only consumer changes it
+    int retSt = 0;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    /* next slot in order is not published yet */
+    if (CBQ_LOAD_ACQ(queue->seqs + (rId & queue->mask)) != rId + 1)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+
+    queue->execSt = CBQ_EST_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* args are used in place: slot is returned to producers only after callback */
+    container = CBQ_CO_AT(&queue->base, rId & queue->mask);
+    if (container->func != NULL)
+        retSt = container->func( (int) container->argc, CBQ_CO_ARGS(container));
+
+    CBQ_STORE_REL(&queue->rId, rId + 1);
+    CBQ_STORE_REL(queue->seqs + (rId & queue->mask), rId + queue->base.capacity);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    queue->execSt = CBQ_EST_NO_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    if (funcRetSt != NULL)
+        *funcRetSt = retSt;
+
+    return 0;
+}
+
+static int CBQ_mpscExecMethod__(void* queue, int* funcRetSt)
+{
+    return CBQ_MpscExec( (CBQMpscQueue_t*) queue, funcRetSt);
+}
+
+int CBQ_MpscExecWait(CBQMpscQueue_t* queue, long timeout, int* funcRetSt)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    return CBQ_execWait__(queue, CBQ_mpscExecMethod__, &queue->waitState, timeout, funcRetSt);
+}
+
+int CBQ_MpscGetSize(const CBQMpscQueue_t* queue, size_t* size)
+{
+    size_t rId, sId;
+
+    OPT_BASE_ERR_CHECK(queue);
+    if (size == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    rId = CBQ_LOAD_ACQ(&queue->rId);
+    sId = CBQ_LOAD_ACQ(&queue->sId);
+    *size = sId > rId? sId - rId : 0;
+
+    return 0;
+}
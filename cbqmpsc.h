@@ -0,0 +1,73 @@
+#ifndef CBQMPSC_H
+#define CBQMPSC_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+#include "cbqspsc.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Multi-producer/single-consumer queue
+     * Lock-free bounded queue for any number of pushing threads and one executing thread
+     * (event-loop mailbox). Producers claim slot by CAS on sId, fill its container and
+     * publish it by per-slot sequence number (Vyukov bounded queue). Consumer takes slots
+     * in order without atomic read-modify-write: exec is wait-free and returns
+     * CBQ_ERR_QUEUE_IS_EMPTY while next slot is not published yet.
+     * Containers are kept in base queue with inline init args capacity (no shared args arena),
+     * bigger args are spilled into heap by producers, so custom allocator must be thread-safe.
+     * Capacity is rounded up to power of two and does not change (push into full queue
+     * returns CBQ_ERR_STATIC_CAPACITY_OVERFLOW).
+     */
+    typedef struct CBQMpscQueue_t CBQMpscQueue_t;
+    struct CBQMpscQueue_t {
+
+        /* init status */
+        int     initSt;
+
+        /* containers storage and slots sequences (read only after init) */
+        CBQueue_t base;
+        size_t* seqs;
+        size_t  mask;
+        char    padBase[CBQ_CACHE_LINE_SIZE];
+
+        /* consumer side */
+        size_t  rId;
+        int     execSt;
+        char    padConsumer[CBQ_CACHE_LINE_SIZE - sizeof(size_t) - sizeof(int)];
+
+        /* producers side */
+        size_t  sId;
+        char    padProducers[CBQ_CACHE_LINE_SIZE - sizeof(size_t)];
+
+        /* sleeping consumers (producers read it on every push) */
+        CBQWaitState_t waitState;
+        char    padWait[CBQ_CACHE_LINE_SIZE - sizeof(CBQWaitState_t)];
+    };
+
+int CBQ_MpscQueueInit(CBQMpscQueue_t* queue, size_t capacity, const CBQAllocator_t* allocator);
+int CBQ_MpscQueueFree(CBQMpscQueue_t* queue);
+
+/* producers methods */
+int CBQ_MpscPush(CBQMpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+int CBQ_MpscPushVoid(CBQMpscQueue_t* queue, QCallback func);
+
+/* consumer methods */
+int CBQ_MpscExec(CBQMpscQueue_t* queue, int* funcRetSt);
+/* sleeps until call is pushed or timeout (ms) is expired, see cbqwait.h */
+int CBQ_MpscExecWait(CBQMpscQueue_t* queue, long timeout, int* funcRetSt);
+
+/* size may be outdated at once, if other side works */
+int CBQ_MpscGetSize(const CBQMpscQueue_t* queue, size_t* size);
+
+/* slots with sequence numbers, shared by MPSC and MPMC queues */
+int CBQ_seqSlotsInit__(CBQueue_t*, size_t**, size_t, const CBQAllocator_t*);
+void CBQ_seqSlotsFree__(CBQueue_t*, size_t*);
+int CBQ_seqSlotsStore__(CBQueue_t*, size_t*, size_t*, QCallback, unsigned int, CBQArg_t*);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQMPSC_H
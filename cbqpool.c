@@ -0,0 +1,101 @@
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqpool.h"
+#include "cbqlocal.h"
+
+#ifdef CBQ_ARGS_POOL
+
+/* Free lists of args buffers by their capacity (linked through first arg) */
+typedef struct CBQArgsPool_t CBQArgsPool_t;
+struct CBQArgsPool_t {
+    CBQArg_t*   freeLists[MAX_CAP_ARGS + 1];
+    size_t      counts[MAX_CAP_ARGS + 1];
+    size_t      hits;
+    size_t      misses;
+    size_t      puts;
+    size_t      drops;
+};
+
+static CBQ_THREAD_LOCAL CBQArgsPool_t argsPool;
+
+CBQArg_t* CBQ_argsPoolTake__(unsigned int capacity)
+{
+    CBQArg_t* args = argsPool.freeLists[capacity];
+
+    if (args == NULL) {
+        argsPool.misses++;
+        return NULL;
+    }
+
+    argsPool.freeLists[capacity] = (CBQArg_t*) args->pVar;
+    argsPool.counts[capacity]--;
+    argsPool.hits++;
+
+    return args;
+}
+
+/* returns non-zero if class is full (buffer must be freed by caller) */
+int CBQ_argsPoolPut__(CBQArg_t* args, unsigned int capacity)
+{
+    if (argsPool.counts[capacity] >= CBQ_ARGS_POOL_CLASS_LIMIT) {
+        argsPool.drops++;
+        return 1;
+    }
+
+    args->pVar = argsPool.freeLists[capacity];
+    argsPool.freeLists[capacity] = args;
+    argsPool.counts[capacity]++;
+    argsPool.puts++;
+
+    return 0;
+}
+
+int CBQ_ArgsPoolGetStats(CBQArgsPoolStats_t* stats)
+{
+    unsigned int i;
+
+    if (stats == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *stats = (CBQArgsPoolStats_t) {
+        .hits = argsPool.hits,
+        .misses = argsPool.misses,
+        .puts = argsPool.puts,
+        .drops = argsPool.drops,
+        .cachedCount = 0,
+        .cachedBytes = 0,
+        .hitRate = argsPool.hits + argsPool.misses?
+            (double) argsPool.hits / (double) (argsPool.hits + argsPool.misses) : 0.0
+    };
+
+    for (i = MIN_CAP_ARGS; i <= MAX_CAP_ARGS; i++) {
+        stats->cachedCount += argsPool.counts[i];
+        stats->cachedBytes += argsPool.counts[i] * i * sizeof(CBQArg_t);
+    }
+
+    return 0;
+}
+
+void CBQ_ArgsPoolResetStats(void)
+{
+    argsPool.hits = argsPool.misses = argsPool.puts = argsPool.drops = 0;
+}
+
+/* Frees all cached buffers of current thread */
+void CBQ_ArgsPoolClear(void)
+{
+    CBQArg_t* args;
+    unsigned int i;
+
+    for (i = MIN_CAP_ARGS; i <= MAX_CAP_ARGS; i++) {
+        while ((args = argsPool.freeLists[i]) != NULL) {
+            argsPool.freeLists[i] = (CBQArg_t*) args->pVar;
+            CBQ_MEMFREE(args);
+        }
+        argsPool.counts[i] = 0;
+    }
+
+    CBQ_MSGPRINT("Args pool cleared");
+}
+
+#endif // CBQ_ARGS_POOL
@@ -0,0 +1,44 @@
+#ifndef CBQPOOL_H
+#define CBQPOOL_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    #ifdef CBQ_ARGS_POOL
+
+    /* Args pool
+     * Spilled args buffers which are released by queues (dec capacity, args capacity change, free)
+     * are kept in free lists by args capacity and taken back by any queue of the same thread
+     * before heap allocation. Pool and its stats are per-thread, so worker thread
+     * should free its cached buffers by CBQ_ArgsPoolClear before exit.
+     * Hit rate is hits / (hits + misses), drops are buffers freed because of full class.
+     */
+    typedef struct CBQArgsPoolStats_t CBQArgsPoolStats_t;
+    struct CBQArgsPoolStats_t {
+        size_t  hits;
+        size_t  misses;
+        size_t  puts;
+        size_t  drops;
+        size_t  cachedCount;
+        size_t  cachedBytes;
+        double  hitRate;
+    };
+
+int CBQ_ArgsPoolGetStats(CBQArgsPoolStats_t* stats);
+void CBQ_ArgsPoolResetStats(void);
+void CBQ_ArgsPoolClear(void);
+
+CBQArg_t* CBQ_argsPoolTake__(unsigned int);
+int CBQ_argsPoolPut__(CBQArg_t*, unsigned int);
+
+    #endif // CBQ_ARGS_POOL
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQPOOL_H
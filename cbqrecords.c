@@ -0,0 +1,326 @@
+#include <string.h>
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqrecords.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+
+/* Record head, args are placed right after it */
+typedef struct CBQRecord_t CBQRecord_t;
+struct CBQRecord_t {
+    QCallback       func;
+    unsigned int    argc;
+};
+
+/* head size is aligned by args size, so all records keep args alignment */
+#define REC_HEAD_SIZE \
+    ((sizeof(CBQRecord_t) + sizeof(CBQArg_t) - 1) / sizeof(CBQArg_t) * sizeof(CBQArg_t))
+
+#define REC_SIZE(ARGC) \
+    (REC_HEAD_SIZE + (size_t) (ARGC) * sizeof(CBQArg_t))
+
+#define REC_NO_WRAP ((size_t) -1)
+
+static int CBQ_recIncCapacity__(CBQRecQueue_t*, size_t);
+static int CBQ_recReserve__(CBQRecQueue_t*, size_t, CBQRecord_t**);
+
+int CBQ_RecQueueInit(CBQRecQueue_t* queue, size_t byteCapacity, int incCapacityMode, size_t maxByteCapacityLimit)
+{
+    CBQRecQueue_t iniQueue = {
+        .execSt = CBQ_EST_NO_EXEC,
+        .retiredRing = NULL,
+        .rOff = 0,
+        .sOff = 0,
+        .wrapOff = REC_NO_WRAP,
+        .usedBytes = 0,
+        .size = 0,
+        .status = CBQ_ST_EMPTY
+    };
+
+    if (queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    /* capacity is aligned by args size (at least for one void record) */
+    byteCapacity = (byteCapacity + sizeof(CBQArg_t) - 1) / sizeof(CBQArg_t) * sizeof(CBQArg_t);
+    if (byteCapacity < REC_HEAD_SIZE || byteCapacity > CBQ_QUEUE_MAX_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    if (incCapacityMode == CBQ_SM_STATIC || incCapacityMode == CBQ_SM_MAX)
+        iniQueue.maxCapacityLimit = 0;
+    else if (incCapacityMode == CBQ_SM_LIMIT && maxByteCapacityLimit >= byteCapacity && maxByteCapacityLimit <= CBQ_QUEUE_MAX_CAPACITY)
+        iniQueue.maxCapacityLimit = maxByteCapacityLimit;
+    else
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    iniQueue.incCapacityMode = incCapacityMode;
+    iniQueue.capacity = byteCapacity;
+
+    iniQueue.ring = (unsigned char*) CBQ_MALLOC(byteCapacity);
+    if (iniQueue.ring == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    iniQueue.initSt = CBQ_IN_INITED;
+    *queue = iniQueue;
+
+    CBQ_MSGPRINT("Records queue initialized");
+    return 0;
+}
+
+int CBQ_RecQueueFree(CBQRecQueue_t* queue)
+{
+    BASE_ERR_CHECK(queue);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    CBQ_MEMFREE(queue->ring);
+    queue->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("Records queue freed");
+    return 0;
+}
+
+int CBQ_RecClear(CBQRecQueue_t* queue)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    queue->rOff = queue->sOff = 0;
+    queue->wrapOff = REC_NO_WRAP;
+    queue->usedBytes = queue->size = 0;
+    queue->status = CBQ_ST_EMPTY;
+
+    return 0;
+}
+
+/* ---------------- Call Methods ---------------- */
+int CBQ_RecPush(CBQRecQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    int errSt;
+    CBQRecord_t* record;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (varParams == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!varParamc)
+        return CBQ_ERR_VPARAM_VARIANCE;
+    #endif
+
+    errSt = CBQ_recReserve__(queue, REC_SIZE(varParamc), &record);
+    if (errSt)
+        return errSt;
+
+    record->func = func;
+    record->argc = varParamc;
+    if (varParamc)
+        CBQ_copyArgs__(varParams, (CBQArg_t*) ((unsigned char*) record + REC_HEAD_SIZE), varParamc);
+
+    CBQ_MSGPRINT("Records queue is pushed");
+    return 0;
+}
+
+int CBQ_RecPushVoid(CBQRecQueue_t* queue, QCallback func)
+{
+    int errSt;
+    CBQRecord_t* record;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    errSt = CBQ_recReserve__(queue, REC_HEAD_SIZE, &record);
+    if (errSt)
+        return errSt;
+
+    record->func = func;
+    record->argc = 0;
+
+    CBQ_MSGPRINT("Records queue is pushed");
+    return 0;
+}
+
+int CBQ_RecExec(CBQRecQueue_t* queue, int* funcRetSt)
+{
+    CBQRecord_t* record;
+    size_t recSize;
+    int prevExecSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (queue->status == CBQ_ST_EMPTY)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    prevExecSt = queue->execSt;
+    queue->execSt = CBQ_EST_EXEC;
+
+    /* the rest of records is after wrapping */
+    if (queue->rOff == queue->wrapOff) {
+        queue->rOff = 0;
+        queue->wrapOff = REC_NO_WRAP;
+    }
+
+    /* Record stays in ring during the call, so pushes from callback do not overwrite it.
+     * If the ring is reallocated meanwhile, the old one is freed after the call.
+     */
+    record = (CBQRecord_t*) (queue->ring + queue->rOff);
+    recSize = REC_SIZE(record->argc);
+
+    if (funcRetSt == NULL)
+        record->func( (int) record->argc, (CBQArg_t*) ((unsigned char*) record + REC_HEAD_SIZE));
+    else
+        *funcRetSt = record->func( (int) record->argc, (CBQArg_t*) ((unsigned char*) record + REC_HEAD_SIZE));
+
+    queue->execSt = prevExecSt;
+    if (queue->execSt == CBQ_EST_NO_EXEC && queue->retiredRing) {
+        CBQ_MEMFREE(queue->retiredRing);
+        queue->retiredRing = NULL;
+    }
+
+    /* read offset (ring may be reordered by growth in callback, then record was moved on rOff) */
+    queue->rOff += recSize;
+    queue->usedBytes -= recSize;
+
+    if (!--queue->size) {
+        queue->rOff = queue->sOff = 0;
+        queue->wrapOff = REC_NO_WRAP;
+        queue->status = CBQ_ST_EMPTY;
+    }
+
+    CBQ_MSGPRINT("Records queue is popped");
+    return 0;
+}
+
+/* ---------------- Info Methods ---------------- */
+int CBQ_RecGetSize(const CBQRecQueue_t* queue, size_t* size)
+{
+    OPT_BASE_ERR_CHECK(queue);
+    if (size == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *size = queue->size;
+    return 0;
+}
+
+int CBQ_RecGetUsedBytes(const CBQRecQueue_t* queue, size_t* usedBytes)
+{
+    OPT_BASE_ERR_CHECK(queue);
+    if (usedBytes == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *usedBytes = queue->usedBytes;
+    return 0;
+}
+
+int CBQ_RecGetCapacityInBytes(const CBQRecQueue_t* queue, size_t* byteCapacity)
+{
+    OPT_BASE_ERR_CHECK(queue);
+    if (byteCapacity == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *byteCapacity = sizeof(CBQRecQueue_t) + queue->capacity;
+    return 0;
+}
+
+/* ---------------- Ring Methods ---------------- */
+/* --r++++++s-----   record is written at store offset if it fits before end of ring,
+ * ++s----r+++w---   otherwise store offset is wrapped and end of records is kept in wrapOff.
+ */
+static int CBQ_recReserve__(CBQRecQueue_t* trustedQueue, size_t recSize, CBQRecord_t** record)
+{
+    int errSt;
+
+    for (;;) {
+        if (trustedQueue->wrapOff == REC_NO_WRAP) {
+            /* space before end of ring */
+            if (trustedQueue->capacity - trustedQueue->sOff >= recSize)
+                break;
+            /* space at start of ring */
+            if (trustedQueue->size && trustedQueue->rOff >= recSize) {
+                trustedQueue->wrapOff = trustedQueue->sOff;
+                trustedQueue->sOff = 0;
+                break;
+            }
+        } else if (trustedQueue->rOff - trustedQueue->sOff >= recSize)
+            break;
+
+        CBQ_MSGPRINT("Records queue is full to push");
+
+        errSt = CBQ_recIncCapacity__(trustedQueue, recSize);
+        if (errSt)
+            return errSt;
+    }
+
+    *record = (CBQRecord_t*) (trustedQueue->ring + trustedQueue->sOff);
+    trustedQueue->sOff += recSize;
+    trustedQueue->usedBytes += recSize;
+    trustedQueue->size++;
+    trustedQueue->status = CBQ_ST_STABLE;
+
+    return 0;
+}
+
+/* Ring is reallocated twice (at least for a new record), records are ordered from start */
+static int CBQ_recIncCapacity__(CBQRecQueue_t* trustedQueue, size_t recSize)
+{
+    unsigned char* newRing;
+    size_t newCapacity, limit, firstSeg;
+
+    if (trustedQueue->incCapacityMode == CBQ_SM_STATIC)
+        return CBQ_ERR_STATIC_CAPACITY_OVERFLOW;
+
+    limit = trustedQueue->incCapacityMode == CBQ_SM_LIMIT?
+        trustedQueue->maxCapacityLimit : CBQ_QUEUE_MAX_CAPACITY;
+
+    if (limit - trustedQueue->usedBytes < recSize)
+        return trustedQueue->incCapacityMode == CBQ_SM_LIMIT?
+            CBQ_ERR_LIMIT_CAPACITY_OVERFLOW : CBQ_ERR_MAX_CAPACITY_OVERFLOW;
+
+    newCapacity = trustedQueue->capacity <= limit >> 1? trustedQueue->capacity << 1 : limit;
+    if (newCapacity - trustedQueue->usedBytes < recSize)
+        newCapacity = trustedQueue->usedBytes + recSize;
+
+    newRing = (unsigned char*) CBQ_MALLOC(newCapacity);
+    if (newRing == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    /* copy records in order */
+    if (trustedQueue->size) {
+        if (trustedQueue->wrapOff == REC_NO_WRAP)
+            firstSeg = trustedQueue->sOff - trustedQueue->rOff;
+        else
+            firstSeg = trustedQueue->wrapOff - trustedQueue->rOff;
+
+        memcpy(newRing, trustedQueue->ring + trustedQueue->rOff, firstSeg);
+        if (trustedQueue->wrapOff != REC_NO_WRAP)
+            memcpy(newRing + firstSeg, trustedQueue->ring, trustedQueue->sOff);
+    }
+
+    /* executed record args may be used in callback yet */
+    if (trustedQueue->execSt == CBQ_EST_EXEC && trustedQueue->retiredRing == NULL)
+        trustedQueue->retiredRing = trustedQueue->ring;
+    else
+        CBQ_MEMFREE(trustedQueue->ring);
+
+    trustedQueue->ring = newRing;
+    trustedQueue->capacity = newCapacity;
+    trustedQueue->rOff = 0;
+    trustedQueue->sOff = trustedQueue->usedBytes;
+    trustedQueue->wrapOff = REC_NO_WRAP;
+
+    CBQ_MSGPRINT("Records queue capacity incremented");
+    return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef CBQRECORDS_H
+#define CBQRECORDS_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Records queue
+     * Queue mode where every call is stored as packed record {func, argc, args[argc]}
+     * right in the byte ring, so void calls take only record head and
+     * there are no unused args slots. Push writes record at store offset,
+     * exec reads them sequentially from read offset.
+     * Capacity (and limit) of that queue is set in bytes, it's changed by
+     * the same capacity modes as in base queue (CBQ_SM_...), but grows twice.
+     * Info macros CBQ_HAVECALL/CBQ_ISEMPTY can be used with that queue too.
+     */
+    typedef struct CBQRecQueue_t CBQRecQueue_t;
+    struct CBQRecQueue_t {
+
+        /* init status */
+        int     initSt;
+
+        /* exec status (also defers free of ring, which was reallocated in callback) */
+        int     execSt;
+
+        /* byte ring */
+        unsigned char* ring;
+        unsigned char* retiredRing;
+        size_t  capacity;
+        size_t  maxCapacityLimit;
+        int     incCapacityMode;
+
+        /* offsets */
+        size_t  rOff;
+        size_t  sOff;
+        size_t  wrapOff;    // end of records before store offset has been wrapped
+        size_t  usedBytes;
+        size_t  size;
+        int     status;
+    };
+
+int CBQ_RecQueueInit(CBQRecQueue_t* queue, size_t byteCapacity, int incCapacityMode, size_t maxByteCapacityLimit);
+int CBQ_RecQueueFree(CBQRecQueue_t* queue);
+int CBQ_RecClear(CBQRecQueue_t* queue);
+
+int CBQ_RecPush(CBQRecQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+int CBQ_RecPushVoid(CBQRecQueue_t* queue, QCallback func);
+int CBQ_RecExec(CBQRecQueue_t* queue, int* funcRetSt);
+
+int CBQ_RecGetSize(const CBQRecQueue_t* queue, size_t* size);
+int CBQ_RecGetUsedBytes(const CBQRecQueue_t* queue, size_t* usedBytes);
+int CBQ_RecGetCapacityInBytes(const CBQRecQueue_t* queue, size_t* byteCapacity);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQRECORDS_H
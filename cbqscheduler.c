@@ -0,0 +1,480 @@
+#include <sched.h>
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqscheduler.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+#include "cbqcapacity.h"
+#ifdef CBQ_ARGS_POOL
+#include "cbqpool.h"
+#endif // CBQ_ARGS_POOL
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error Scheduler needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+#define SCHED_MAX_DEQUE_CAPACITY ((SIZE_MAX >> 2) + 1)
+
+/* Local deque of worker: owner takes calls from tail, thieves take them from head.
+ * Ids are free-running, cells are taken by mask. Calls are moved in and out of cells
+ * (spilled args by ownership), so free cells keep nothing.
+ */
+struct CBQSchedWorker_t {
+    CBQScheduler_t* scheduler;
+    pthread_t       thread;
+    unsigned int    index;
+
+    pthread_mutex_t lock;
+    CBQContainer_t* cells;
+    size_t          capacity;
+    size_t          head;
+    size_t          tail;
+    size_t          size;   // copy of deque size for lockless checks
+
+    char            pad[CBQ_CACHE_LINE_SIZE];
+};
+
+/* worker of current thread (pushes from its callbacks go into own deque) */
+static CBQ_THREAD_LOCAL CBQSchedWorker_t* curWorker = NULL;
+
+static void CBQ_schedWorkersFree__(CBQScheduler_t* scheduler, unsigned int count);
+static int CBQ_dequeReserve__(CBQScheduler_t* scheduler, CBQSchedWorker_t* worker, size_t count);
+static int CBQ_dequePop__(CBQSchedWorker_t* worker, CBQContainer_t* call);
+static int CBQ_dequeSteal__(CBQScheduler_t* scheduler, CBQSchedWorker_t* thief);
+static int CBQ_schedStore__(CBQScheduler_t* scheduler, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+static int CBQ_schedHaveCalls__(CBQScheduler_t* scheduler);
+static void CBQ_schedPark__(CBQScheduler_t* scheduler);
+static void* CBQ_schedWorker__(void* arg);
+
+int CBQ_SchedulerInit(CBQScheduler_t* scheduler, unsigned int threadsCount, size_t initDequeCapacity, unsigned int spinCount,
+                      unsigned int parkTimeout, CBQErrHook errHook, void* hookCtx, const CBQAllocator_t* allocator)
+{
+    CBQSchedWorker_t* worker;
+    pthread_condattr_t condAttr;
+    unsigned int i;
+    int errSt;
+
+    if (scheduler == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (scheduler->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    if (!threadsCount || threadsCount > CBQ_EXECUTOR_MAX_THREADS ||
+        initDequeCapacity < CBQ_QUEUE_MIN_CAPACITY || initDequeCapacity > SCHED_MAX_DEQUE_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    scheduler->argsBase = (CBQueue_t) {0};
+    errSt = CBQ_QueueInitWithAllocator(&scheduler->argsBase, CBQ_QUEUE_MIN_CAPACITY, CBQ_SM_STATIC, 0, CBQ_INLINE_ARGS, allocator);
+    if (errSt)
+        return errSt;
+
+    scheduler->workers = (CBQSchedWorker_t*) CBQ_QMALLOC(&scheduler->argsBase, sizeof(CBQSchedWorker_t) * threadsCount);
+    if (scheduler->workers == NULL) {
+        CBQ_QueueFree(&scheduler->argsBase);
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+
+    scheduler->threadsCount = threadsCount;
+    initDequeCapacity = CBQ_roundUpPow2__(initDequeCapacity);
+
+    for (i = 0; i < threadsCount; i++) {
+        worker = scheduler->workers + i;
+        worker->scheduler = scheduler;
+        worker->index = i;
+        worker->capacity = initDequeCapacity;
+        worker->head = worker->tail = worker->size = 0;
+
+        worker->cells = (CBQContainer_t*) CBQ_QMALLOC(&scheduler->argsBase, sizeof(CBQContainer_t) * initDequeCapacity);
+        if (worker->cells == NULL || pthread_mutex_init(&worker->lock, NULL)) {
+            if (worker->cells != NULL)
+                CBQ_QMEMFREE(&scheduler->argsBase, worker->cells, sizeof(CBQContainer_t) * initDequeCapacity);
+            CBQ_schedWorkersFree__(scheduler, i);
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        }
+    }
+
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    if (pthread_mutex_init(&scheduler->parkLock, NULL) || pthread_cond_init(&scheduler->parkCond, &condAttr)) {
+        pthread_condattr_destroy(&condAttr);
+        CBQ_schedWorkersFree__(scheduler, threadsCount);
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+    pthread_condattr_destroy(&condAttr);
+
+    scheduler->state = CBQ_EXS_IDLE;
+    scheduler->spinCount = spinCount;
+    scheduler->parkTimeout = parkTimeout;
+    scheduler->errHook = errHook;
+    scheduler->hookCtx = hookCtx;
+    scheduler->pending = 0;
+    scheduler->nextWorker = 0;
+    scheduler->parked = 0;
+
+    scheduler->initSt = CBQ_IN_INITED;
+
+    CBQ_MSGPRINT("Scheduler initialized");
+    return 0;
+}
+
+/* Calls, which are left in deques, are dropped */
+int CBQ_SchedulerFree(CBQScheduler_t* scheduler)
+{
+    BASE_ERR_CHECK(scheduler);
+
+    if (scheduler->state != CBQ_EXS_IDLE)
+        return CBQ_ERR_IS_BUSY;
+
+    pthread_cond_destroy(&scheduler->parkCond);
+    pthread_mutex_destroy(&scheduler->parkLock);
+    CBQ_schedWorkersFree__(scheduler, scheduler->threadsCount);
+    scheduler->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("Scheduler freed");
+    return 0;
+}
+
+static void CBQ_schedWorkersFree__(CBQScheduler_t* scheduler, unsigned int count)
+{
+    CBQSchedWorker_t* worker;
+    CBQContainer_t* call;
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        worker = scheduler->workers + i;
+
+        for (; worker->head != worker->tail; worker->head++) {
+            call = worker->cells + (worker->head & (worker->capacity - 1));
+            if (!CBQ_CO_IS_INLINE(call))
+                CBQ_heapArgsFree__(&scheduler->argsBase, call->args.ext, call->capacity);
+        }
+
+        CBQ_QMEMFREE(&scheduler->argsBase, worker->cells, sizeof(CBQContainer_t) * worker->capacity);
+        pthread_mutex_destroy(&worker->lock);
+    }
+
+    CBQ_QMEMFREE(&scheduler->argsBase, scheduler->workers, sizeof(CBQSchedWorker_t) * scheduler->threadsCount);
+    CBQ_QueueFree(&scheduler->argsBase);
+}
+
+int CBQ_SchedulerStart(CBQScheduler_t* scheduler)
+{
+    unsigned int i;
+
+    BASE_ERR_CHECK(scheduler);
+
+    if (scheduler->state != CBQ_EXS_IDLE)
+        return CBQ_ERR_IS_BUSY;
+
+    CBQ_STORE_REL(&scheduler->state, CBQ_EXS_RUN);
+
+    for (i = 0; i < scheduler->threadsCount; i++)
+        if (pthread_create(&scheduler->workers[i].thread, NULL, CBQ_schedWorker__, scheduler->workers + i)) {
+            /* stop already started workers */
+            const unsigned int threadsCount = scheduler->threadsCount;
+
+            scheduler->threadsCount = i;
+            CBQ_SchedulerStop(scheduler, 0);
+            scheduler->threadsCount = threadsCount;
+            return CBQ_ERR_THREAD_START_FAILED;
+        }
+
+    CBQ_MSGPRINT("Scheduler started");
+    return 0;
+}
+
+int CBQ_SchedulerStop(CBQScheduler_t* scheduler, const int drain)
+{
+    unsigned int i;
+
+    BASE_ERR_CHECK(scheduler);
+
+    if (scheduler->state == CBQ_EXS_IDLE)
+        return 0;
+
+    if (curWorker != NULL && curWorker->scheduler == scheduler)
+        return CBQ_ERR_IS_BUSY;
+
+    pthread_mutex_lock(&scheduler->parkLock);
+    CBQ_STORE_REL(&scheduler->state, drain? CBQ_EXS_DRAIN : CBQ_EXS_STOP);
+    pthread_cond_broadcast(&scheduler->parkCond);
+    pthread_mutex_unlock(&scheduler->parkLock);
+
+    for (i = 0; i < scheduler->threadsCount; i++)
+        pthread_join(scheduler->workers[i].thread, NULL);
+
+    scheduler->state = CBQ_EXS_IDLE;
+
+    CBQ_MSGPRINT("Scheduler stopped");
+    return 0;
+}
+
+/* ---------------- Deques ---------------- */
+/* Under lock of worker */
+static int CBQ_dequeReserve__(CBQScheduler_t* scheduler, CBQSchedWorker_t* worker, size_t count)
+{
+    CBQContainer_t* cells;
+    const size_t size = worker->tail - worker->head;
+    size_t newCapacity = worker->capacity, i;
+
+    if (size + count <= worker->capacity)
+        return 0;
+
+    while (newCapacity < size + count)
+        newCapacity <<= 1;
+
+    cells = (CBQContainer_t*) CBQ_QMALLOC(&scheduler->argsBase, sizeof(CBQContainer_t) * newCapacity);
+    if (cells == NULL)
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+
+    for (i = 0; i < size; i++)
+        cells[i] = worker->cells[(worker->head + i) & (worker->capacity - 1)];
+
+    CBQ_QMEMFREE(&scheduler->argsBase, worker->cells, sizeof(CBQContainer_t) * worker->capacity);
+    worker->cells = cells;
+    worker->capacity = newCapacity;
+    worker->head = 0;
+    worker->tail = size;
+
+    return 0;
+}
+
+/* Owner takes newest call */
+static int CBQ_dequePop__(CBQSchedWorker_t* worker, CBQContainer_t* call)
+{
+    int taken = 0;
+
+    if (!CBQ_LOAD_RLX(&worker->size))
+        return 0;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->tail != worker->head) {
+        *call = worker->cells[--worker->tail & (worker->capacity - 1)];
+        CBQ_STORE_REL(&worker->size, worker->tail - worker->head);
+        taken = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return taken;
+}
+
+/* Thief moves older half of first not empty deque into own one */
+static int CBQ_dequeSteal__(CBQScheduler_t* scheduler, CBQSchedWorker_t* thief)
+{
+    CBQSchedWorker_t *victim, *first, *second;
+    size_t count, i;
+    unsigned int k;
+
+    for (k = 1; k < scheduler->threadsCount; k++) {
+        victim = scheduler->workers + (thief->index + k) % scheduler->threadsCount;
+        if (!CBQ_LOAD_RLX(&victim->size))
+            continue;
+
+        /* locks are always taken in order of workers */
+        first = victim->index < thief->index? victim : thief;
+        second = first == victim? thief : victim;
+        pthread_mutex_lock(&first->lock);
+        pthread_mutex_lock(&second->lock);
+
+        count = victim->tail - victim->head;
+        count -= count / 2;
+        if (count && CBQ_dequeReserve__(scheduler, thief, count))
+            count = 0;
+
+        for (i = 0; i < count; i++)
+            thief->cells[thief->tail++ & (thief->capacity - 1)] = victim->cells[victim->head++ & (victim->capacity - 1)];
+
+        CBQ_STORE_REL(&victim->size, victim->tail - victim->head);
+        CBQ_STORE_REL(&thief->size, thief->tail - thief->head);
+
+        pthread_mutex_unlock(&second->lock);
+        pthread_mutex_unlock(&first->lock);
+
+        if (count)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* ---------------- Push Methods ---------------- */
+static int CBQ_schedStore__(CBQScheduler_t* scheduler, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    CBQSchedWorker_t* worker;
+    CBQContainer_t call;
+    int errSt;
+
+    if (varParamc > MAX_CAP_ARGS)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    /* call is made out of lock */
+    call.func = func;
+    call.argc = varParamc;
+    call.capacity = CBQ_INLINE_ARGS;
+    if (varParamc > CBQ_INLINE_ARGS) {
+        call.args.ext = CBQ_heapArgsAlloc__(&scheduler->argsBase, varParamc);
+        if (call.args.ext == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        call.capacity = varParamc;
+        call.argsSt = CBQ_AST_HEAP;
+    }
+
+    if (varParamc)
+        CBQ_copyArgs__(varParams, CBQ_CO_ARGS(&call), varParamc);
+
+    /* pushes from callbacks go into own deque, others are spread by round-robin */
+    worker = curWorker;
+    if (worker == NULL || worker->scheduler != scheduler)
+        worker = scheduler->workers + CBQ_FETCH_ADD(&scheduler->nextWorker, 1) % scheduler->threadsCount;
+
+    /* pending is counted before call is visible, so drain cannot miss it */
+    CBQ_FETCH_ADD(&scheduler->pending, 1);
+
+    pthread_mutex_lock(&worker->lock);
+    errSt = CBQ_dequeReserve__(scheduler, worker, 1);
+    if (!errSt) {
+        worker->cells[worker->tail++ & (worker->capacity - 1)] = call;
+        CBQ_STORE_REL(&worker->size, worker->tail - worker->head);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    if (errSt) {
+        CBQ_FETCH_SUB(&scheduler->pending, 1);
+        if (!CBQ_CO_IS_INLINE(&call))
+            CBQ_heapArgsFree__(&scheduler->argsBase, call.args.ext, call.capacity);
+        return errSt;
+    }
+
+    /* pairs with fence of parking worker: either it sees pushed call, or push sees it parked */
+    CBQ_FENCE();
+    if (CBQ_LOAD_RLX(&scheduler->parked)) {
+        pthread_mutex_lock(&scheduler->parkLock);
+        pthread_cond_signal(&scheduler->parkCond);
+        pthread_mutex_unlock(&scheduler->parkLock);
+    }
+
+    return 0;
+}
+
+int CBQ_SchedulerPush(CBQScheduler_t* scheduler, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    OPT_BASE_ERR_CHECK(scheduler);
+
+    #ifndef NO_VPARAM_CHECK
+    if (varParams == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!varParamc)
+        return CBQ_ERR_VPARAM_VARIANCE;
+    #endif
+
+    return CBQ_schedStore__(scheduler, func, varParamc, varParams);
+}
+
+int CBQ_SchedulerPushVoid(CBQScheduler_t* scheduler, QCallback func)
+{
+    OPT_BASE_ERR_CHECK(scheduler);
+
+    return CBQ_schedStore__(scheduler, func, 0, NULL);
+}
+
+int CBQ_SchedulerGetPending(const CBQScheduler_t* scheduler, size_t* pending)
+{
+    OPT_BASE_ERR_CHECK(scheduler);
+    if (pending == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *pending = CBQ_LOAD_ACQ(&scheduler->pending);
+
+    return 0;
+}
+
+/* ---------------- Workers ---------------- */
+static int CBQ_schedHaveCalls__(CBQScheduler_t* scheduler)
+{
+    unsigned int i;
+
+    for (i = 0; i < scheduler->threadsCount; i++)
+        if (CBQ_LOAD_ACQ(&scheduler->workers[i].size))
+            return 1;
+
+    return 0;
+}
+
+static void CBQ_schedPark__(CBQScheduler_t* scheduler)
+{
+    struct timespec deadline;
+
+    pthread_mutex_lock(&scheduler->parkLock);
+    CBQ_FETCH_ADD(&scheduler->parked, 1);
+    CBQ_FENCE();
+
+    /* calls could be pushed before worker was counted as parked */
+    if (CBQ_LOAD_ACQ(&scheduler->state) == CBQ_EXS_RUN && !CBQ_schedHaveCalls__(scheduler)) {
+        if (scheduler->parkTimeout) {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += scheduler->parkTimeout / 1000;
+            deadline.tv_nsec += (long) (scheduler->parkTimeout % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&scheduler->parkCond, &scheduler->parkLock, &deadline);
+        } else
+            pthread_cond_wait(&scheduler->parkCond, &scheduler->parkLock);
+    }
+
+    CBQ_FETCH_SUB(&scheduler->parked, 1);
+    pthread_mutex_unlock(&scheduler->parkLock);
+}
+
+static void* CBQ_schedWorker__(void* arg)
+{
+    CBQSchedWorker_t* worker = (CBQSchedWorker_t*) arg;
+    CBQScheduler_t* scheduler = worker->scheduler;
+    CBQContainer_t call;
+    unsigned int idleSpins = 0;
+    int state, retSt;
+
+    curWorker = worker;
+
+    for (;;) {
+        if (CBQ_dequePop__(worker, &call)) {
+            retSt = call.func( (int) call.argc, CBQ_CO_ARGS(&call));
+
+            if (!CBQ_CO_IS_INLINE(&call))
+                CBQ_heapArgsFree__(&scheduler->argsBase, call.args.ext, call.capacity);
+
+            if (retSt && scheduler->errHook != NULL)
+                scheduler->errHook(scheduler->hookCtx, scheduler, retSt);
+
+            CBQ_FETCH_SUB(&scheduler->pending, 1);
+            idleSpins = 0;
+            continue;
+        }
+
+        if (CBQ_dequeSteal__(scheduler, worker))
+            continue;
+
+        state = CBQ_LOAD_ACQ(&scheduler->state);
+        if (state == CBQ_EXS_STOP || (state == CBQ_EXS_DRAIN && !CBQ_LOAD_ACQ(&scheduler->pending)))
+            break;
+
+        if (idleSpins < scheduler->spinCount) {
+            idleSpins++;
+            CBQ_CPU_RELAX();
+        } else if (state == CBQ_EXS_RUN) {
+            CBQ_schedPark__(scheduler);
+            idleSpins = 0;
+        } else
+            sched_yield();  // drain: last calls are finished by other workers
+    }
+
+    curWorker = NULL;
+
+    #ifdef CBQ_ARGS_POOL
+    CBQ_ArgsPoolClear();
+    #endif // CBQ_ARGS_POOL
+
+    return NULL;
+}
@@ -0,0 +1,70 @@
+#ifndef CBQSCHEDULER_H
+#define CBQSCHEDULER_H
+
+#include <pthread.h>
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+#include "cbqexecutor.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    typedef struct CBQSchedWorker_t CBQSchedWorker_t;
+
+    /* Work-stealing scheduler
+     * Every worker thread owns local deque of calls. Calls which are pushed from callbacks
+     * of worker go into its own deque, calls from other threads are spread over deques by
+     * round-robin. Worker executes newest call of own deque (depth-first for recursive
+     * fan-out), idle worker steals older half of other deque at once.
+     * Order of calls is not kept. Idle workers spin, then park until push (any push wakes
+     * parked worker) or park timeout (in ms, 0 - without timeout).
+     * Deques grow by doubling from initial capacity and are allocated with allocator,
+     * which must be thread-safe (NULL - default one). Stop with drain waits for all calls,
+     * including pushed by running callbacks.
+     */
+    typedef struct CBQScheduler_t CBQScheduler_t;
+    struct CBQScheduler_t {
+        int initSt;
+        int state;
+
+        unsigned int    threadsCount;
+        unsigned int    spinCount;
+        unsigned int    parkTimeout;
+        CBQErrHook      errHook;
+        void*           hookCtx;
+
+        /* keeps allocator of deques and spilled args */
+        CBQueue_t           argsBase;
+        CBQSchedWorker_t*   workers;
+
+        /* pushed and not finished calls, round-robin counter of pushes from other threads */
+        size_t          pending;
+        unsigned int    nextWorker;
+
+        /* parking of idle workers */
+        int             parked;
+        pthread_mutex_t parkLock;
+        pthread_cond_t  parkCond;
+    };
+
+int CBQ_SchedulerInit(CBQScheduler_t* scheduler, unsigned int threadsCount, size_t initDequeCapacity, unsigned int spinCount,
+                      unsigned int parkTimeout, CBQErrHook errHook, void* hookCtx, const CBQAllocator_t* allocator);
+int CBQ_SchedulerFree(CBQScheduler_t* scheduler);
+
+int CBQ_SchedulerStart(CBQScheduler_t* scheduler);
+/* Waits for workers, must not be called from callbacks of scheduler */
+int CBQ_SchedulerStop(CBQScheduler_t* scheduler, const int drain);
+
+/* Could be called from any thread (also before start) */
+int CBQ_SchedulerPush(CBQScheduler_t* scheduler, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+int CBQ_SchedulerPushVoid(CBQScheduler_t* scheduler, QCallback func);
+
+/* Pushed calls, which are not finished yet (may be outdated at once) */
+int CBQ_SchedulerGetPending(const CBQScheduler_t* scheduler, size_t* pending);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQSCHEDULER_H
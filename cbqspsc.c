@@ -0,0 +1,195 @@
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqspsc.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+#include "cbqcapacity.h"
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error SPSC queue needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+#define SPSC_MAX_CAPACITY ((SIZE_MAX >> 2) + 1)
+
+static int CBQ_spscStore__(CBQSpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+
+int CBQ_SpscQueueInit(CBQSpscQueue_t* queue, size_t capacity, unsigned int customInitArgsCapacity, const CBQAllocator_t* allocator)
+{
+    int errSt;
+    CBQSpscQueue_t iniQueue = {
+        .base = {0},
+        .rId = 0,
+        .cachedSId = 0,
+        .execSt = CBQ_EST_NO_EXEC,
+        .sId = 0,
+        .cachedRId = 0
+    };
+
+    if (queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    if (capacity < CBQ_QUEUE_MIN_CAPACITY || capacity > SPSC_MAX_CAPACITY)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    /* base queue only keeps containers (its capacity may be rounded up by storage, but stays power of two) */
+    errSt = CBQ_QueueInitWithAllocator(&iniQueue.base, CBQ_roundUpPow2__(capacity), CBQ_SM_STATIC, 0, customInitArgsCapacity, allocator);
+    if (errSt)
+        return errSt;
+
+    iniQueue.mask = iniQueue.base.capacity - 1;
+
+    iniQueue.initSt = CBQ_IN_INITED;
+    *queue = iniQueue;
+
+    CBQ_MSGPRINT("SPSC queue initialized");
+    return 0;
+}
+
+/* Both sides must be stopped */
+int CBQ_SpscQueueFree(CBQSpscQueue_t* queue)
+{
+    BASE_ERR_CHECK(queue);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    CBQ_QueueFree(&queue->base);
+    queue->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("SPSC queue freed");
+    return 0;
+}
+
+/* ---------------- Producer Methods ---------------- */
+static int CBQ_spscStore__(CBQSpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    CBQContainer_t* container;
+    const size_t sId = queue->sId;  // only producer changes it
+    int errSt;
+
+    /* other side is read only when queue looks full */
+    if (sId - queue->cachedRId > queue->mask) {
+        queue->cachedRId = CBQ_LOAD_ACQ(&queue->rId);
+        if (sId - queue->cachedRId > queue->mask)
+            return CBQ_ERR_STATIC_CAPACITY_OVERFLOW;
+    }
+
+    /* container is owned by producer until sId is published */
+    container = CBQ_CO_AT(&queue->base, sId & queue->mask);
+
+    #ifdef CBQ_LAZY_INIT
+    if (CBQ_CO_IS_UNINITED(container)) {
+        errSt = CBQ_containerLazyInit__(&queue->base, container);
+        if (errSt)
+            return errSt;
+    }
+    #endif // CBQ_LAZY_INIT
+
+    if (varParamc > container->capacity) {
+        errSt = CBQ_changeArgsCapacity__(&queue->base, container, varParamc, 0);
+        if (errSt)
+            return errSt;
+    }
+
+    if (varParamc)
+        CBQ_copyArgs__(varParams, CBQ_CO_ARGS(container), varParamc);
+
+    container->argc = varParamc;
+    container->func = func;
+
+    CBQ_STORE_REL(&queue->sId, sId + 1);
+    CBQ_notifyWaiter__(&queue->waitState);
+
+    return 0;
+}
+
+int CBQ_SpscPush(CBQSpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (varParams == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!varParamc)
+        return CBQ_ERR_VPARAM_VARIANCE;
+    #endif
+
+    return CBQ_spscStore__(queue, func, varParamc, varParams);
+}
+
+int CBQ_SpscPushVoid(CBQSpscQueue_t* queue, QCallback func)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    return CBQ_spscStore__(queue, func, 0, NULL);
+}
+
+/* ---------------- Consumer Methods ---------------- */
+int CBQ_SpscExec(CBQSpscQueue_t* queue, int* funcRetSt)
+{
+    CBQContainer_t* container;
+    const size_t rId = queue->rId;  // only consumer changes it
+    int retSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    /* other side is read only when queue looks empty */
+    if (rId == queue->cachedSId) {
+        queue->cachedSId = CBQ_LOAD_ACQ(&queue->sId);
+        if (rId == queue->cachedSId)
+            return CBQ_ERR_QUEUE_IS_EMPTY;
+    }
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+
+    queue->execSt = CBQ_EST_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* args are used in place: container is returned to producer only after callback */
+    container = CBQ_CO_AT(&queue->base, rId & queue->mask);
+    retSt = container->func( (int) container->argc, CBQ_CO_ARGS(container));
+
+    CBQ_STORE_REL(&queue->rId, rId + 1);
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    queue->execSt = CBQ_EST_NO_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    if (funcRetSt != NULL)
+        *funcRetSt = retSt;
+
+    return 0;
+}
+
+static int CBQ_spscExecMethod__(void* queue, int* funcRetSt)
+{
+    return CBQ_SpscExec( (CBQSpscQueue_t*) queue, funcRetSt);
+}
+
+int CBQ_SpscExecWait(CBQSpscQueue_t* queue, long timeout, int* funcRetSt)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    return CBQ_execWait__(queue, CBQ_spscExecMethod__, &queue->waitState, timeout, funcRetSt);
+}
+
+int CBQ_SpscGetSize(const CBQSpscQueue_t* queue, size_t* size)
+{
+    size_t rId;
+
+    OPT_BASE_ERR_CHECK(queue);
+    if (size == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    rId = CBQ_LOAD_ACQ(&queue->rId);
+    *size = CBQ_LOAD_ACQ(&queue->sId) - rId;
+
+    return 0;
+}
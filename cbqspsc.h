@@ -0,0 +1,73 @@
+#ifndef CBQSPSC_H
+#define CBQSPSC_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+#include "cbqwait.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Size of cache line for separation of producer and consumer data (may be set in cbqbuildconf.h) */
+    #ifndef CBQ_CACHE_LINE_SIZE
+        #define CBQ_CACHE_LINE_SIZE 64
+    #endif
+
+    /* Single-producer/single-consumer queue
+     * Lock-free bounded queue for one pushing thread and one executing thread.
+     * Producer owns sId, consumer owns rId, both are free-running counters on separate
+     * cache lines and they are published with release/acquire ordering. Each side
+     * keeps cached copy of other id, so it reads other cache line only when queue looks full/empty.
+     * Containers (with inline and spilled args) are kept in base queue, which is not used
+     * as queue itself, spilled args are changed only by producer.
+     * Capacity is rounded up to power of two and does not change (push into full queue
+     * returns CBQ_ERR_STATIC_CAPACITY_OVERFLOW).
+     */
+    typedef struct CBQSpscQueue_t CBQSpscQueue_t;
+    struct CBQSpscQueue_t {
+
+        /* init status */
+        int     initSt;
+
+        /* containers storage, allocator and args capacity (read only after init) */
+        CBQueue_t base;
+        size_t  mask;
+        char    padBase[CBQ_CACHE_LINE_SIZE];
+
+        /* consumer side */
+        size_t  rId;
+        size_t  cachedSId;
+        int     execSt;
+        char    padConsumer[CBQ_CACHE_LINE_SIZE - 2 * sizeof(size_t) - sizeof(int)];
+
+        /* producer side */
+        size_t  sId;
+        size_t  cachedRId;
+        char    padProducer[CBQ_CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+        /* sleeping consumers (producers read it on every push) */
+        CBQWaitState_t waitState;
+        char    padWait[CBQ_CACHE_LINE_SIZE - sizeof(CBQWaitState_t)];
+    };
+
+int CBQ_SpscQueueInit(CBQSpscQueue_t* queue, size_t capacity, unsigned int customInitArgsCapacity, const CBQAllocator_t* allocator);
+int CBQ_SpscQueueFree(CBQSpscQueue_t* queue);
+
+/* producer methods */
+int CBQ_SpscPush(CBQSpscQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
+int CBQ_SpscPushVoid(CBQSpscQueue_t* queue, QCallback func);
+
+/* consumer methods */
+int CBQ_SpscExec(CBQSpscQueue_t* queue, int* funcRetSt);
+/* sleeps until call is pushed or timeout (ms) is expired, see cbqwait.h */
+int CBQ_SpscExecWait(CBQSpscQueue_t* queue, long timeout, int* funcRetSt);
+
+/* size may be outdated at once, if other side works */
+int CBQ_SpscGetSize(const CBQSpscQueue_t* queue, size_t* size);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQSPSC_H
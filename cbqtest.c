@@ -753,6 +753,10 @@ void CBQ_T_VerIdInfo(int APIVer)
     printf("Fix arg types status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_NFIXARGTYPES)? "false" : "true");
     printf("VParam check status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_NVPARAMCHECK)? "false" : "true");
     printf("Register vars status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_REGCYCLEVARS)? "true" : "false");
+    printf("Power of two capacity status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_POW2CAPACITY)? "true" : "false");
+    printf("Chunked storage status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_CHUNKEDSTORAGE)? "true" : "false");
+    printf("Args pool status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_ARGSPOOL)? "true" : "false");
+    printf("Lazy init status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_LAZYINIT)? "true" : "false");
     printf("Debug status: %s\n", CBQ_CheckVerIndexByFlag(CBQ_VI_DEBUG)? "true" : "false");
 }
 
@@ -921,3 +925,908 @@ void CBQ_T_CallingConvection(void)
 }
 
 #endif
+
+/* ---------------- Records queue ---------------- */
+void CBQ_T_RecordsTest(void)
+{
+    CBQRecQueue_t queue;
+    size_t size, usedBytes, capacityBytes;
+    int retst = 0;
+
+    ASRT(CBQ_RecQueueInit(&queue, CBQ_SI_TINY * sizeof(CBQArg_t), CBQ_SM_LIMIT, CBQ_SI_BIG), "Failed to init records queue")
+
+    ASRT(CBQ_RecPushVoid(&queue, CB_0_Args), "Failed to push void record")
+    ASRT(CBQ_RecPush(&queue, CB_2_Args_Sum, 2, (CBQArg_t[]) {{.iVar = 4}, {.iVar = 6}}), "Failed to push record")
+    ASRT(CBQ_RecPush(&queue, CB_5_Args_PrintNums, 5, (CBQArg_t[]) {{1}, {2}, {3}, {4}, {5}}), "Failed to push record")  // ring is auto inc in that part
+    ASRT(CBQ_RecPush(&queue, addAllNumsCB, 10, (CBQArg_t[]) {{1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}}), "Failed to push record")
+
+    CBQ_RecGetSize(&queue, &size);
+    CBQ_RecGetUsedBytes(&queue, &usedBytes);
+    CBQ_RecGetCapacityInBytes(&queue, &capacityBytes);
+    printf("records: " SZ_PRTF ", used bytes: " SZ_PRTF ", capacity in bytes: " SZ_PRTF "\n", size, usedBytes, capacityBytes);
+
+    while (CBQ_HAVECALL(queue)) {
+        ASRT(CBQ_RecExec(&queue, &retst), "Failed to exec record")
+        if (retst)
+            printf("Record CB returned %d\n", retst);
+    }
+
+    ASRT(CBQ_RecQueueFree(&queue), "Failed to free records queue")
+}
+
+/* bump allocator: memory is taken from buffer in order and released wholesale (by reset) */
+typedef struct {
+    unsigned char* buff;
+    size_t size;
+    size_t used;
+} BumpArena_t;
+
+static void* bumpAlloc(void* ctx, size_t size)
+{
+    BumpArena_t* arena = (BumpArena_t*) ctx;
+    void* ptr;
+
+    size = (size + sizeof(CBQArg_t) - 1) / sizeof(CBQArg_t) * sizeof(CBQArg_t);
+    if (size > arena->size - arena->used)
+        return NULL;
+
+    ptr = arena->buff + arena->used;
+    arena->used += size;
+
+    return ptr;
+}
+
+static void* bumpResize(void* ctx, void* ptr, size_t oldSize, size_t newSize)
+{
+    unsigned char* newPtr = (unsigned char*) bumpAlloc(ctx, newSize);
+    size_t len = oldSize < newSize? oldSize : newSize;
+
+    if (newPtr != NULL)
+        while (len--)
+            newPtr[len] = ((unsigned char*) ptr)[len];
+
+    return newPtr;
+}
+
+static void bumpRelease(UNUSED void* ctx, UNUSED void* ptr, UNUSED size_t size)
+{
+}
+
+void CBQ_T_AllocatorTest(void)
+{
+    static CBQArg_t buff[4096];
+    BumpArena_t arena = {(unsigned char*) buff, sizeof(buff), 0};
+    CBQAllocator_t allocator = {bumpAlloc, bumpResize, bumpRelease, &arena, NULL};   // alloc with zeroing
+    CBQueue_t queue = {0};
+    size_t size, executed;
+    int retst = 0;
+
+    for (int round = 0; round < 3; round++) {
+        ASRT(CBQ_QueueInitWithAllocator(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_MEDIUM, 0, &allocator), "Failed to init queue with allocator")
+
+        for (int i = 0; i < CBQ_SI_TINY * 2; i++)
+            ASRT(CBQ_PushN(&queue, CB_2_Args_Sum, {.iVar = i}, {.iVar = round}), "Failed to push call")
+        ASRT(CBQ_PushN(&queue, addAllNumsCB, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}), "Failed to push call")
+
+        printf("round %d, arena used bytes: " SZ_PRTF "\n", round, arena.used);
+
+        while (CBQ_HAVECALL(queue))
+            ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+
+        ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+        arena.used = 0; // all queue memory is released at once
+    }
+
+    #if !defined(NO_REST_MEM_FAIL) && !defined(CBQ_CHUNKED_STORAGE)
+    /* failed decrement of divided ring keeps its calls (chunks are released without ring realloc) */
+    ASRT(CBQ_QueueInitWithAllocator(&queue, CBQ_SI_SMALL, CBQ_SM_MAX, 0, 0, &allocator), "Failed to init queue with allocator")
+    for (int i = 0; i < CBQ_SI_SMALL; i++)
+        ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    for (int i = 0; i < 24; i++)
+        ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    for (int i = 0; i < 8; i++)
+        ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+
+    arena.used = arena.size;    // resize of ring fails
+    retst = CBQ_ChangeCapacity(&queue, CBQ_CUSTOM_CAPACITY, CBQ_SI_SMALL / 2, 0);
+    printf("Failed decrement restored queue: %d of 1\n", retst == CBQ_ERR_MEM_BUT_RESTORED);
+
+    ASRT(CBQ_GetSize(&queue, &size), "Failed to get size")
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL), "Failed to exec all")
+    printf("Calls after failed decrement: " SZ_PRTF ", executed " SZ_PRTF " of 16\n", size, executed);
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+    arena.used = 0;
+    #endif // NO_REST_MEM_FAIL, CBQ_CHUNKED_STORAGE
+}
+
+#ifdef CBQ_ARGS_POOL
+void CBQ_T_ArgsPoolTest(void)
+{
+    CBQueue_t queue = {0};
+    CBQArgsPoolStats_t stats;
+    int retst = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_SMALL, CBQ_SM_MAX, 0, 0), "Failed to init queue")
+
+    /* bursts of mixed-arity calls, spilled args buffers are returned into pool by exec and capacity decrement */
+    for (int burst = 0; burst < 4; burst++) {
+        for (int i = 0; i < CBQ_SI_MEDIUM; i++)
+            if (i % 2)
+                ASRT(CBQ_PushN(&queue, addAllNumsCB, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}), "Failed to push call")
+            else
+                ASRT(CBQ_PushN(&queue, CB_2_Args_Sum, {.iVar = i}, {.iVar = burst}), "Failed to push call")
+
+        while (CBQ_HAVECALL(queue))
+            ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+
+        ASRT(CBQ_ChangeCapacity(&queue, CBQ_DEC_CAPACITY, 0, 1), "Failed to decrement capacity")
+
+        CBQ_ArgsPoolGetStats(&stats);
+        printf("burst %d, pool hits: " SZ_PRTF ", misses: " SZ_PRTF ", drops: " SZ_PRTF ", cached bytes: " SZ_PRTF ", hit rate: %.2f\n",
+               burst, stats.hits, stats.misses, stats.drops, stats.cachedBytes, stats.hitRate);
+    }
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+    CBQ_ArgsPoolClear();
+}
+#endif // CBQ_ARGS_POOL
+
+void CBQ_T_AutoShrinkTest(void)
+{
+    CBQueue_t queue = {0};
+    size_t size;
+    int retst = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_MAX, 0, 0), "Failed to init queue")
+    ASRT(CBQ_SetAutoShrink(&queue, 25, 4, 0, CBQ_SI_TINY), "Failed to set auto shrink policy")
+
+    /* traffic spike */
+    for (int i = 0; i < CBQ_SI_BIG; i++)
+        ASRT(CBQ_PushN(&queue, CB_2_Args_Sum, {.iVar = i}, {.iVar = 1}), "Failed to push call")
+
+    printf("after spike capacity: " SZ_PRTF ", inc capacity: " SZ_PRTF "\n", CBQ_GETCAPACITY(queue), queue.incCapacity);
+
+    while (CBQ_HAVECALL(queue)) {
+        ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+        CBQ_GetSize(&queue, &size);
+        if (size % 64 == 0)
+            printf("size: " SZ_PRTF ", capacity: " SZ_PRTF "\n", size, CBQ_GETCAPACITY(queue));
+    }
+
+    printf("after drain capacity: " SZ_PRTF ", inc capacity: " SZ_PRTF "\n", CBQ_GETCAPACITY(queue), queue.incCapacity);
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+void CBQ_T_SpscTest(void)
+{
+    CBQSpscQueue_t queue = {0};
+    size_t size;
+    int retst = 0;
+
+    ASRT(CBQ_SpscQueueInit(&queue, 6, 0, NULL), "Failed to init SPSC queue")   // capacity is 8
+
+    /* producer side (one thread) */
+    ASRT(CBQ_SpscPushVoid(&queue, CB_0_Args), "Failed to push void call")
+    ASRT(CBQ_SpscPush(&queue, CB_2_Args_Sum, 2, (CBQArg_t[]) {{.iVar = 4}, {.iVar = 6}}), "Failed to push call")
+    ASRT(CBQ_SpscPush(&queue, addAllNumsCB, 10, (CBQArg_t[]) {{1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}}), "Failed to push call")
+
+    while (!CBQ_SpscPushVoid(&queue, CB_0_Args))
+        ;
+    CBQ_SpscGetSize(&queue, &size);
+    printf("SPSC queue is full with " SZ_PRTF " calls\n", size);
+
+    /* consumer side (other thread) */
+    while (!CBQ_SpscExec(&queue, &retst))
+        if (retst)
+            printf("SPSC CB returned %d\n", retst);
+
+    ASRT(CBQ_SpscQueueFree(&queue), "Failed to free SPSC queue")
+}
+
+void CBQ_T_MpscTest(void)
+{
+    CBQMpscQueue_t queue = {0};
+    size_t size;
+    int retst = 0;
+
+    ASRT(CBQ_MpscQueueInit(&queue, 6, NULL), "Failed to init MPSC queue")   // capacity is 8
+
+    /* producers side (any threads) */
+    ASRT(CBQ_MpscPushVoid(&queue, CB_0_Args), "Failed to push void call")
+    ASRT(CBQ_MpscPush(&queue, CB_2_Args_Sum, 2, (CBQArg_t[]) {{.iVar = 4}, {.iVar = 6}}), "Failed to push call")
+    ASRT(CBQ_MpscPush(&queue, addAllNumsCB, 10, (CBQArg_t[]) {{1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}}), "Failed to push call")
+
+    while (!CBQ_MpscPushVoid(&queue, CB_0_Args))
+        ;
+    CBQ_MpscGetSize(&queue, &size);
+    printf("MPSC queue is full with " SZ_PRTF " calls\n", size);
+
+    /* consumer side (one thread) */
+    while (!CBQ_MpscExec(&queue, &retst))
+        if (retst)
+            printf("MPSC CB returned %d\n", retst);
+
+    ASRT(CBQ_MpscQueueFree(&queue), "Failed to free MPSC queue")
+}
+
+void CBQ_T_MpmcTest(void)
+{
+    CBQMpmcQueue_t queue = {0};
+    size_t size;
+    int retst = 0;
+
+    ASRT(CBQ_MpmcQueueInit(&queue, 6, NULL), "Failed to init MPMC queue")   // capacity is 8
+
+    /* producers side (any threads) */
+    ASRT(CBQ_MpmcPushVoid(&queue, CB_0_Args), "Failed to push void call")
+    ASRT(CBQ_MpmcPush(&queue, CB_2_Args_Sum, 2, (CBQArg_t[]) {{.iVar = 4}, {.iVar = 6}}), "Failed to push call")
+    ASRT(CBQ_MpmcPush(&queue, addAllNumsCB, 10, (CBQArg_t[]) {{1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}, {10}}), "Failed to push call")
+
+    while (!CBQ_MpmcPushVoid(&queue, CB_0_Args))
+        ;
+    CBQ_MpmcGetSize(&queue, &size);
+    printf("MPMC queue is full with " SZ_PRTF " calls\n", size);
+
+    /* consumers side (any threads, calls are taken in push order) */
+    while (!CBQ_MpmcExec(&queue, &retst))
+        if (retst)
+            printf("MPMC CB returned %d\n", retst);
+
+    ASRT(CBQ_MpmcQueueFree(&queue), "Failed to free MPMC queue")
+}
+
+int oddNumCB(UNUSED int argc, CBQArg_t* args)
+{
+    return args[0].iVar % 2;
+}
+
+void execErrHook(void* hookCtx, UNUSED void* queue, int funcRetSt)
+{
+    __atomic_add_fetch( (int*) hookCtx, funcRetSt, __ATOMIC_RELAXED);
+}
+
+void CBQ_T_ExecutorTest(void)
+{
+    CBQMpmcQueue_t queue = {0};
+    CBQExecutor_t executor = {0};
+    int i, errCount = 0;
+
+    ASRT(CBQ_MpmcQueueInit(&queue, 64, NULL), "Failed to init MPMC queue")
+    ASRT(CBQ_ExecutorInit(&executor, 4, 1000, 0, execErrHook, &errCount), "Failed to init executor")
+    ASRT(CBQ_ExecutorAddQueue(&executor, CBQ_EXQ_MPMC, &queue), "Failed to add queue into executor")
+    ASRT(CBQ_ExecutorStart(&executor), "Failed to start executor")
+
+    /* workers are parked without calls, so push is followed by notify */
+    for (i = 0; i < 100; i++) {
+        while (CBQ_MpmcPush(&queue, oddNumCB, 1, (CBQArg_t[]) {{.iVar = i}}) == CBQ_ERR_STATIC_CAPACITY_OVERFLOW)
+            CBQ_ExecutorNotify(&executor);
+        CBQ_ExecutorNotify(&executor);
+    }
+
+    ASRT(CBQ_ExecutorStop(&executor, 1), "Failed to stop executor")
+    printf("Executor error hook got %d odd numbers of 100\n", errCount);
+
+    ASRT(CBQ_ExecutorFree(&executor), "Failed to free executor")
+    ASRT(CBQ_MpmcQueueFree(&queue), "Failed to free MPMC queue")
+}
+
+/* Recursive fan-out: every node pushes two child nodes from own callback */
+int fanOutNodeCB(UNUSED int argc, CBQArg_t* args)
+{
+    if (!args[1].iVar) {
+        __atomic_add_fetch( (int*) args[2].pVar, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    args[1].iVar--;
+    ASRT(CBQ_SchedulerPush(args[0].pVar, fanOutNodeCB, 3, args), "Failed to push node")
+    ASRT(CBQ_SchedulerPush(args[0].pVar, fanOutNodeCB, 3, args), "Failed to push node")
+    return 0;
+}
+
+void CBQ_T_SchedulerTest(void)
+{
+    CBQScheduler_t scheduler = {0};
+    int leaves = 0;
+
+    ASRT(CBQ_SchedulerInit(&scheduler, 4, CBQ_SI_TINY, 1000, 0, NULL, NULL, NULL), "Failed to init scheduler")
+    ASRT(CBQ_SchedulerStart(&scheduler), "Failed to start scheduler")
+
+    /* children go into deque of worker, idle workers steal them */
+    ASRT(CBQ_SchedulerPush(&scheduler, fanOutNodeCB, 3, (CBQArg_t[]) {{.pVar = &scheduler}, {.iVar = 12}, {.pVar = &leaves}}), "Failed to push root")
+
+    ASRT(CBQ_SchedulerStop(&scheduler, 1), "Failed to stop scheduler")
+    printf("Scheduler tree has %d leaves of 4096\n", leaves);
+
+    ASRT(CBQ_SchedulerFree(&scheduler), "Failed to free scheduler")
+}
+
+/* Producer thread of waiting exec test: pushes calls with pauses, so consumer sleeps between them */
+void* waitProducer(void* args)
+{
+    CBQArg_t* wArgs = args;
+    struct timespec pause = {0, 20000000L};
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        nanosleep(&pause, NULL);
+        ASRT(CBQ_MpscPush(wArgs[0].pVar, oddNumCB, 1, (CBQArg_t[]) {{.iVar = i}}), "Failed to push call")
+    }
+
+    return NULL;
+}
+
+void CBQ_T_ExecWaitTest(void)
+{
+    CBQMpscQueue_t queue = {0};
+    CBQArg_t producerArgs[1] = {{.pVar = &queue}};  // it is read by producer until join
+    pthread_t producer;
+    int retst, errSt, calls = 0;
+
+    ASRT(CBQ_MpscQueueInit(&queue, 8, NULL), "Failed to init MPSC queue")
+
+    /* nobody pushes: spin only and timed waits return empty status */
+    ASRT(CBQ_MpscExecWait(&queue, 0, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Spin only wait must return empty status")
+    ASRT(CBQ_MpscExecWait(&queue, 10, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Timed wait must return empty status")
+
+    ASRT(pthread_create(&producer, NULL, waitProducer, producerArgs), "Failed to start producer")
+
+    /* consumer sleeps until each push */
+    while (calls < 5) {
+        errSt = CBQ_MpscExecWait(&queue, CBQ_WAIT_INFINITE, &retst);
+        ASRT(errSt, "Failed to exec call")
+        calls++;
+    }
+
+    pthread_join(producer, NULL);
+    printf("Waiting exec got %d calls of 5\n", calls);
+
+    ASRT(CBQ_MpscQueueFree(&queue), "Failed to free MPSC queue")
+}
+
+void sumRetHook(void* hookCtx, int funcRetSt)
+{
+    *(int*) hookCtx += funcRetSt;
+}
+
+int selfPushCB(UNUSED int argc, CBQArg_t* args)
+{
+    ASRT(CBQ_PushOnlyVP(args[0].qVar, oddNumCB, 1, (CBQArg_t[]) {{.iVar = 1}}), "Failed to push call from callback")
+    return 0;
+}
+
+void CBQ_T_ExecBatchTest(void)
+{
+    CBQueue_t queue = {0};
+    size_t executed;
+    int i, oddCount = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_MEDIUM, 0), "Failed to init queue")
+
+    for (i = 0; i < 20; i++)
+        ASRT(CBQ_PushN(&queue, oddNumCB, {.iVar = i}), "Failed to push call")
+
+    ASRT(CBQ_ExecBatch(&queue, 8, &executed, sumRetHook, &oddCount), "Failed to exec batch")
+    printf("Batch executed " SZ_PRTF " calls of 8, odd numbers: %d of 4\n", executed, oddCount);
+
+    /* call pushed by callback is left for next drain */
+    ASRT(CBQ_PushN(&queue, selfPushCB, {.qVar = &queue}), "Failed to push call")
+    ASRT(CBQ_ExecAll(&queue, &executed, sumRetHook, &oddCount), "Failed to exec all")
+    printf("ExecAll executed " SZ_PRTF " calls of 13, odd numbers: %d of 10\n", executed, oddCount);
+
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL), "Failed to exec all")
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+int busyLoopCB(UNUSED int argc, CBQArg_t* args)
+{
+    volatile int i;
+
+    for (i = 0; i < args[0].iVar; i++)
+        ;
+    return 0;
+}
+
+void CBQ_T_ExecForTest(void)
+{
+    CBQueue_t queue = {0};
+    size_t executed, remain;
+    int i;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_MEDIUM, CBQ_SM_LIMIT, CBQ_SI_HUGE, 0), "Failed to init queue")
+
+    for (i = 0; i < 8000; i++)
+        ASRT(CBQ_PushN(&queue, busyLoopCB, {.iVar = 10000}), "Failed to push call")
+
+    /* one frame of 1 ms */
+    ASRT(CBQ_ExecFor(&queue, 1000000ULL, &executed, &remain, NULL, NULL), "Failed to exec for budget")
+    printf("Frame executed " SZ_PRTF " calls, " SZ_PRTF " remain\n", executed, remain);
+
+    /* rest of calls are drained frame by frame */
+    for (i = 1; remain; i++)
+        ASRT(CBQ_ExecFor(&queue, 1000000ULL, &executed, &remain, NULL, NULL), "Failed to exec for budget")
+    printf("Calls are drained in %d frames, " SZ_PRTF " remain\n", i, remain);
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+void CBQ_T_PushBatchTest(void)
+{
+    CBQueue_t queue = {0};
+    CBQCall_t calls[40];
+    CBQArg_t nums[40];
+    size_t size;
+    int i, oddCount = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, 64, 0), "Failed to init queue")
+
+    for (i = 0; i < 40; i++) {
+        nums[i].iVar = i;
+        calls[i] = (CBQCall_t) {oddNumCB, 1, nums + i};
+    }
+
+    /* ring is divided before capacity incrementation */
+    ASRT(CBQ_PushN(&queue, oddNumCB, {.iVar = 1}), "Failed to push call")
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+
+    ASRT(CBQ_PushBatch(&queue, calls, 5), "Failed to push batch")
+    ASRT(CBQ_PushBatch(&queue, calls + 5, 35), "Failed to push batch")
+    CBQ_GetSize(&queue, &size);
+    printf("Queue size after batches: " SZ_PRTF " of 40, capacity " SZ_PRTF "\n", size, queue.capacity);
+
+    /* batch does not fit in limit, queue is not changed */
+    ASRT(CBQ_PushBatch(&queue, calls, 40) != CBQ_ERR_LIMIT_CAPACITY_OVERFLOW, "Batch must not fit in limit")
+
+    ASRT(CBQ_ExecAll(&queue, NULL, sumRetHook, &oddCount), "Failed to exec all")
+    printf("Batches have %d odd numbers of 20\n", oddCount);
+
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+void CBQ_T_PushReserveTest(void)
+{
+    CBQueue_t queue = {0}, srcQueue = {0};
+    CBQArg_t* args;
+    size_t capacity;
+    int i, retst;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_SMALL, 0), "Failed to init queue")
+
+    /* wide call: args are written into queue memory */
+    ASRT(CBQ_PushReserve(&queue, addAllNumsCB, 20, &args), "Failed to reserve call")
+    for (i = 0; i < 20; i++)
+        args[i].iVar = i + 1;
+
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args) != CBQ_ERR_IS_BUSY, "Push must wait for commit")
+    ASRT(CBQ_PushCommit(&queue), "Failed to commit call")
+    ASRT(CBQ_PushCommit(&queue) != CBQ_ERR_NOT_RESERVED, "Second commit must fail")
+
+    /* canceled call is not pushed */
+    ASRT(CBQ_PushReserve(&queue, CB_0_Args, 0, &args), "Failed to reserve call")
+    ASRT(CBQ_PushCancel(&queue), "Failed to cancel call")
+
+    ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    ASRT(CBQ_Exec(&queue, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+
+    /* capacity is not changed while cell is reserved */
+    CBQ_ChangeCapacity(&queue, CBQ_CUSTOM_CAPACITY, CBQ_SI_SMALL, 1);
+    capacity = queue.capacity;
+    ASRT(CBQ_SetAutoShrink(&queue, 25, 1, 0, CBQ_SI_TINY), "Failed to set auto shrink policy")
+    ASRT(CBQ_QueueInit(&srcQueue, CBQ_SI_TINY, CBQ_SM_MAX, 0, 0), "Failed to init queue")
+
+    ASRT(CBQ_PushN(&queue, oddNumCB, {.iVar = 1}), "Failed to push call")
+    ASRT(CBQ_PushReserve(&queue, addAllNumsCB, 20, &args), "Failed to reserve call")
+    for (i = 0; i < 20; i++)
+        args[i].iVar = i + 1;
+
+    ASRT(CBQ_ChangeCapacity(&queue, CBQ_DEC_CAPACITY, 0, 1) != CBQ_ERR_IS_BUSY, "Capacity change must wait for commit")
+    ASRT(CBQ_EqualizeArgsCapByCustom(&queue, 4, 1) != CBQ_ERR_IS_BUSY, "Args capacity change must wait for commit")
+    #ifdef CBQ_ALLOW_V2_METHODS
+    ASRT(CBQ_PushVoid(&srcQueue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_QueueTransfer(&queue, &srcQueue, 1, 0, 0) != CBQ_ERR_IS_BUSY, "Transfer must wait for commit")
+    #endif // CBQ_ALLOW_V2_METHODS
+
+    ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    printf("Capacity with reservation after exec: " SZ_PRTF " of " SZ_PRTF "\n", queue.capacity, capacity);
+
+    /* committed call sums its args (210) */
+    ASRT(CBQ_PushCommit(&queue), "Failed to commit call")
+    ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    ASRT(CBQ_Exec(&queue, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+
+    ASRT(CBQ_QueueFree(&srcQueue), "Failed to free queue")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+int timerCountCB(UNUSED int argc, CBQArg_t* args)
+{
+    (*(int*) args[0].pVar)++;
+    return 0;
+}
+
+void CBQ_T_TimerWheelTest(void)
+{
+    CBQueue_t queue = {0};
+    CBQTimerWheel_t wheel = {0};
+    CBQTimerHandle_t handle, farHandle, staleHandle;
+    size_t moved, pending, total = 0;
+    int i, retst, fired = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_MEDIUM, 0), "Failed to init queue")
+    /* wheel tick is 1 ms */
+    ASRT(CBQ_TimerWheelInit(&wheel, 1000000ULL, NULL), "Failed to init wheel")
+    ASRT(CBQ_QueueAttachTimers(&queue, &wheel), "Failed to attach wheel")
+
+    /* timers of different levels, far timer is canceled */
+    for (i = 0; i < 100; i++)
+        ASRT(CBQ_TimerAdd(&wheel, (i % 10) * 2000000ULL, &queue, timerCountCB, 1,
+            (CBQArg_t[]) {{.pVar = &fired}}, &handle), "Failed to add timer")
+    ASRT(CBQ_TimerAdd(&wheel, 3600 * 1000000000ULL, &queue, CB_0_Args, 0, NULL, &farHandle), "Failed to add timer")
+
+    staleHandle = farHandle;
+    ASRT(CBQ_TimerCancel(&wheel, &farHandle), "Failed to cancel timer")
+    ASRT(CBQ_TimerCancel(&wheel, &staleHandle) != CBQ_ERR_HANDLE_IS_STALE, "Handle must be stale")
+
+    /* SetTimeout goes into wheel */
+    ASRT(CBQ_SetTimeout(&queue, CLOCKS_PER_SEC / 100, 0, &queue, CB_0_Args, 0, NULL), "Failed to set timeout")
+
+    ASRT(CBQ_TimerWheelGetCount(&wheel, &pending), "Failed to get count")
+    printf("Pending timers: " SZ_PRTF " of 101\n", pending);
+
+    while (pending) {
+        ASRT(CBQ_TimerWheelAdvance(&wheel, &moved), "Failed to advance wheel")
+        total += moved;
+        ASRT(CBQ_TimerWheelGetCount(&wheel, &pending), "Failed to get count")
+    }
+    printf("Moved calls: " SZ_PRTF " of 101\n", total);
+
+    for (i = 0; i < 101; i++)
+        ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    ASRT(CBQ_Exec(&queue, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+    printf("Fired timers: %d of 100\n", fired);
+
+    /* batched exec advances wheel itself */
+    ASRT(CBQ_TimerAdd(&wheel, 0, &queue, CB_0_Args, 0, NULL, NULL), "Failed to add timer")
+    do {
+        retst = CBQ_ExecAll(&queue, &moved, NULL, NULL);
+    } while (retst == CBQ_ERR_QUEUE_IS_EMPTY);
+    ASRT(retst, "Failed to exec all")
+
+    ASRT(CBQ_QueueAttachTimers(&queue, NULL), "Failed to detach wheel")
+    ASRT(CBQ_TimerWheelFree(&wheel), "Failed to free wheel")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+void CBQ_T_SetTimeoutNsTest(void)
+{
+    CBQueue_t queue = {0};
+    #if CBQ_TIMER_METHODS != 1
+    struct timespec pause = {0, 30000000L};
+    #endif // CBQ_TIMER_METHODS
+    size_t executed;
+    int fired = 0, retst;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_SMALL, 0), "Failed to init queue")
+
+    ASRT(CBQ_SetTimeoutNs(&queue, 20000000ULL, &queue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &fired}}, NULL), "Failed to set timeout")
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL), "Failed to exec all")
+    printf("Fired before delay: %d of 0\n", fired);
+
+    #if CBQ_TIMER_METHODS != 1
+    /* sleeping process does not spend processor time, but delay is wall time */
+    nanosleep(&pause, NULL);
+    ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    #else
+    /* with clock() delay is processor time, so it is spent by exec loop (bounded) */
+    for (long i = 0; !fired && i < 100000000L; i++)
+        ASRT(CBQ_Exec(&queue, &retst), "Failed to exec call")
+    #endif // CBQ_TIMER_METHODS
+    printf("Fired after delay: %d of 1\n", fired);
+
+    ASRT(CBQ_Exec(&queue, &retst) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+/* state: [0] - last key, [1] - fired calls, [2] - calls out of deadline order */
+int deadlineOrderCB(UNUSED int argc, CBQArg_t* args)
+{
+    int* state = args[0].pVar;
+
+    if (args[1].iVar < state[0])
+        state[2]++;
+    state[0] = args[1].iVar;
+    state[1]++;
+    return 0;
+}
+
+void CBQ_T_DeadlineHeapTest(void)
+{
+    CBQueue_t queue = {0};
+    CBQDeadlineHeap_t heap = {0};
+    CBQTimerHandle_t handles[100], staleHandle, sentinel;
+    struct timespec pause, wallStart, wallEnd;
+    unsigned long long waitNs, wallNs;
+    clock_t cpuStart;
+    size_t executed, pending;
+    int i, state[3] = {-1, 0, 0};
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_MEDIUM, 0), "Failed to init queue")
+    ASRT(CBQ_DeadlineHeapInit(&heap, 0, NULL), "Failed to init heap")
+    ASRT(CBQ_QueueAttachDeadlines(&queue, &heap), "Failed to attach heap")
+
+    ASRT(CBQ_NextDeadline(&queue, &waitNs) != CBQ_ERR_QUEUE_IS_EMPTY, "Nothing must be pending")
+
+    /* keys are shuffled, each key has deadline of key * 0.2 ms after deadline of sentinel.
+     * It is read by CBQ_NextDeadline before each add, so slow adds do not change order of deadlines.
+     */
+    ASRT(CBQ_DeadlineAdd(&heap, 30000000ULL, &queue, CB_0_Args, 0, NULL, &sentinel), "Failed to add sentinel")
+
+    for (i = 0; i < 100; i++) {
+        ASRT(CBQ_NextDeadline(&queue, &waitNs), "Failed to get next deadline")
+        ASRT(CBQ_DeadlineAdd(&heap, waitNs + (i * 37 % 100) * 200000ULL, &queue, deadlineOrderCB, 2,
+            (CBQArg_t[]) {{.pVar = state}, {.iVar = i * 37 % 100}}, &handles[i]), "Failed to add deadline")
+    }
+
+    ASRT(CBQ_DeadlineCancel(&heap, &sentinel), "Failed to cancel sentinel")
+
+    for (i = 0; i < 100; i += 4)
+        ASRT(CBQ_DeadlineCancel(&heap, &handles[i]), "Failed to cancel deadline")
+
+    staleHandle = handles[1];
+    ASRT(CBQ_DeadlineCancel(&heap, &handles[1]), "Failed to cancel deadline")
+    ASRT(CBQ_DeadlineCancel(&heap, &staleHandle) != CBQ_ERR_HANDLE_IS_STALE, "Handle must be stale")
+
+    /* SetTimeout goes into heap */
+    ASRT(CBQ_SetTimeoutNs(&queue, 25000000ULL, &queue, CB_0_Args, 0, NULL, NULL), "Failed to set timeout")
+
+    ASRT(CBQ_DeadlineHeapGetCount(&heap, &pending), "Failed to get count")
+    printf("Pending deadlines: " SZ_PRTF " of 75\n", pending);
+
+    /* sleeping event loop */
+    cpuStart = clock();
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+    while (CBQ_NextDeadline(&queue, &waitNs) != CBQ_ERR_QUEUE_IS_EMPTY) {
+        if (waitNs) {
+            pause.tv_sec = (time_t) (waitNs / 1000000000ULL);
+            pause.tv_nsec = (long) (waitNs % 1000000000ULL);
+            nanosleep(&pause, NULL);
+        }
+        CBQ_ExecAll(&queue, &executed, NULL, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    wallNs = (unsigned long long) (wallEnd.tv_sec - wallStart.tv_sec) * 1000000000ULL + (unsigned long long) wallEnd.tv_nsec - (unsigned long long) wallStart.tv_nsec;
+
+    printf("Fired deadlines: %d of 74, out of order: %d of 0\n", state[1], state[2]);
+    printf("Loop slept most of time: %d of 1\n",
+        (unsigned long long) (clock() - cpuStart) * (1000000000ULL / CLOCKS_PER_SEC) < wallNs / 2);
+
+    ASRT(CBQ_QueueAttachDeadlines(&queue, NULL), "Failed to detach heap")
+    ASRT(CBQ_DeadlineHeapFree(&heap), "Failed to free heap")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
+
+static unsigned long long elapsedNs(const struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long) (now.tv_sec - start->tv_sec) * 1000000000ULL + (unsigned long long) now.tv_nsec - (unsigned long long) start->tv_nsec;
+}
+
+/* Sleep which is seen by timer methods: with clock() (processor time) it is busy wait */
+static void timerSleep(const struct timespec* pause)
+{
+    #if CBQ_TIMER_METHODS != 1
+    nanosleep(pause, NULL);
+    #else
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (elapsedNs(&start) < (unsigned long long) pause->tv_sec * 1000000000ULL + (unsigned long long) pause->tv_nsec)
+        ;
+    #endif // CBQ_TIMER_METHODS
+}
+
+void CBQ_T_SetIntervalTest(void)
+{
+    CBQueue_t queue = {0}, frameQueue = {0};
+    CBQDeadlineHeap_t heap = {0};
+    CBQTimerHandle_t handle;
+    struct timespec pause, start, overrun = {0, 45000000L};
+    unsigned long long waitNs, periods;
+    size_t executed, pending;
+    int skipped = 0, caught = 0, framed = 0, beforeSkip, beforeCatch;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_SMALL, 0), "Failed to init queue")
+    ASRT(CBQ_DeadlineHeapInit(&heap, 0, NULL), "Failed to init heap")
+    ASRT(CBQ_QueueAttachDeadlines(&queue, &heap), "Failed to attach heap")
+
+    ASRT(CBQ_SetInterval(&queue, 0, CBQ_IP_SKIP, &queue, CB_0_Args, 0, NULL, NULL) != CBQ_ERR_ARG_OUT_OF_RANGE, "Zero period must be rejected")
+
+    /* both intervals have period of 10 ms, each is anchored to time of its set, so catch-up one is a bit later */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ASRT(CBQ_SetInterval(&queue, 10000000ULL, CBQ_IP_SKIP, &queue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &skipped}}, NULL), "Failed to set interval")
+    ASRT(CBQ_SetInterval(&queue, 10000000ULL, CBQ_IP_CATCH_UP, &queue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &caught}}, NULL), "Failed to set interval")
+
+    /* sleeping event loop for 5 periods of both intervals */
+    while (skipped < 5 || caught < 5) {
+        ASRT(CBQ_NextDeadline(&queue, &waitNs), "Failed to get next deadline")
+        if (waitNs) {
+            pause.tv_sec = 0;
+            pause.tv_nsec = (long) waitNs;
+            timerSleep(&pause);
+        }
+        CBQ_ExecAll(&queue, &executed, NULL, NULL);
+    }
+    printf("Fired on cadence: %d of 5, %d of 5\n", skipped, caught);
+
+    /* loop is late for about 4.5 periods */
+    beforeSkip = skipped;
+    beforeCatch = caught;
+    timerSleep(&overrun);
+    CBQ_ExecAll(&queue, &executed, NULL, NULL);
+
+    periods = elapsedNs(&start) / 10000000ULL;
+    printf("Skip policy fired once after overrun: %d of 1\n", skipped - beforeSkip == 1);
+    printf("Catch-up policy fired missed periods: %d of 1\n", caught - beforeCatch >= 4 && (unsigned long long) caught + 1 >= periods);
+
+    ASRT(CBQ_DeadlineHeapGetCount(&heap, &pending), "Failed to get count")
+    printf("Pending intervals: " SZ_PRTF " of 2\n", pending);
+
+    /* periodic timer is pending until cancel */
+    ASRT(CBQ_DeadlineAddPeriodic(&heap, 1000000ULL, CBQ_IP_SKIP, &queue, CB_0_Args, 0, NULL, &handle), "Failed to add periodic deadline")
+    ASRT(CBQ_DeadlineCancel(&heap, &handle), "Failed to cancel periodic deadline")
+
+    ASRT(CBQ_QueueAttachDeadlines(&queue, NULL), "Failed to detach heap")
+    ASRT(CBQ_DeadlineHeapFree(&heap), "Failed to free heap")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+
+    /* without heap or wheel interval frame is pushed again */
+    ASRT(CBQ_QueueInit(&frameQueue, CBQ_SI_TINY, CBQ_SM_LIMIT, CBQ_SI_SMALL, 0), "Failed to init queue")
+    ASRT(CBQ_SetInterval(&frameQueue, 10000000ULL, CBQ_IP_SKIP, &frameQueue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &framed}}, NULL), "Failed to set interval")
+
+    pause.tv_sec = 0;
+    pause.tv_nsec = 1000000L;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (elapsedNs(&start) < 58000000ULL) {
+        ASRT(CBQ_Exec(&frameQueue, NULL), "Failed to exec call")
+        timerSleep(&pause);
+    }
+    printf("Fired by frame: %d of 5\n", framed);
+
+    ASRT(CBQ_QueueFree(&frameQueue), "Failed to free queue")
+}
+
+void CBQ_T_CancelTest(void)
+{
+    CBQueue_t queue = {0};
+    #ifdef CBQ_ALLOW_V2_METHODS
+    CBQueue_t destQueue = {0};
+    #endif // CBQ_ALLOW_V2_METHODS
+    CBQDeadlineHeap_t heap = {0};
+    CBQHandle_t handles[1000], staleHandle;
+    size_t size, executed, pending;
+    int i, fired = 0;
+
+    ASRT(CBQ_QueueInit(&queue, CBQ_SI_TINY, CBQ_SM_MAX, 0, 0), "Failed to init queue")
+
+    for (i = 0; i < 10; i++) {
+        ASRT(CBQ_PushOnlyVP(&queue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &fired}}), "Failed to push call")
+        ASRT(CBQ_LastCallHandle(&queue, &handles[i]), "Failed to get handle")
+    }
+
+    /* calls in the middle become tombstones */
+    for (i = 1; i < 9; i += 2)
+        ASRT(CBQ_Cancel(&handles[i]), "Failed to cancel call")
+    CBQ_GetSize(&queue, &size);
+    printf("Size with tombstones: " SZ_PRTF " of 10\n", size);
+
+    /* tombstones at the ends are dropped */
+    ASRT(CBQ_Cancel(&handles[9]), "Failed to cancel call")
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    ASRT(CBQ_Cancel(&handles[0]), "Failed to cancel call")
+    #else
+    /* exec status is unknown, so call in read cell is not cancelled, it is executed instead */
+    ASRT(CBQ_Cancel(&handles[0]) != CBQ_ERR_IS_BUSY, "Call in read cell must not be cancelled")
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+    fired = 0;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+    CBQ_GetSize(&queue, &size);
+    printf("Size after cancel of ends: " SZ_PRTF " of 7\n", size);
+
+    staleHandle = handles[2];
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+    ASRT(CBQ_Cancel(&staleHandle) != CBQ_ERR_HANDLE_IS_STALE, "Handle of executed call must be stale")
+
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL), "Failed to exec all")
+    printf("Fired calls: %d of 4, executed by batch: " SZ_PRTF " of 3\n", fired, executed);
+
+    #ifdef CBQ_ALLOW_V2_METHODS
+    /* skipped call gives its sequence number to next push, but not its generation */
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_LastCallHandle(&queue, &staleHandle), "Failed to get handle")
+    ASRT(CBQ_Skip(&queue, 1, 0, 1), "Failed to skip call")
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_Cancel(&staleHandle) != CBQ_ERR_HANDLE_IS_STALE, "Handle of skipped call must be stale")
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+    #endif // CBQ_ALLOW_V2_METHODS
+
+    /* tombstone which is left at the front by exec is dropped */
+    for (i = 0; i < 3; i++) {
+        ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+        ASRT(CBQ_LastCallHandle(&queue, &handles[i]), "Failed to get handle")
+    }
+    ASRT(CBQ_Cancel(&handles[1]), "Failed to cancel call")
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+    CBQ_GetSize(&queue, &size);
+    printf("Size after exec before tombstone: " SZ_PRTF " of 1\n", size);
+
+    #ifdef CBQ_ALLOW_V2_METHODS
+    /* and by skip at the back */
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_LastCallHandle(&queue, &handles[0]), "Failed to get handle")
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_Cancel(&handles[0]), "Failed to cancel call")
+    ASRT(CBQ_Skip(&queue, 1, 0, 1), "Failed to skip call")
+    CBQ_GetSize(&queue, &size);
+    printf("Size after skip before tombstone: " SZ_PRTF " of 1\n", size);
+
+    /* and by transfer from the front */
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_LastCallHandle(&queue, &handles[0]), "Failed to get handle")
+    ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+    ASRT(CBQ_Cancel(&handles[0]), "Failed to cancel call")
+    ASRT(CBQ_QueueInit(&destQueue, CBQ_SI_TINY, CBQ_SM_MAX, 0, 0), "Failed to init queue")
+    ASRT(CBQ_QueueTransfer(&destQueue, &queue, 1, 0, 0), "Failed to transfer call")
+    CBQ_GetSize(&queue, &size);
+    printf("Size after transfer before tombstone: " SZ_PRTF " of 1\n", size);
+    ASRT(CBQ_QueueFree(&destQueue), "Failed to free queue")
+    #endif // CBQ_ALLOW_V2_METHODS
+
+    ASRT(CBQ_Exec(&queue, NULL), "Failed to exec call")
+    ASRT(CBQ_Exec(&queue, NULL) != CBQ_ERR_QUEUE_IS_EMPTY, "Queue must be empty")
+
+    /* tombstones are not counted by batch and by remaining calls */
+    for (i = 0; i < 40; i++) {
+        ASRT(CBQ_PushVoid(&queue, CB_0_Args), "Failed to push call")
+        ASRT(CBQ_LastCallHandle(&queue, &handles[i]), "Failed to get handle")
+    }
+    ASRT(CBQ_Cancel(&handles[1]), "Failed to cancel call")
+    ASRT(CBQ_Cancel(&handles[2]), "Failed to cancel call")
+    ASRT(CBQ_Cancel(&handles[37]), "Failed to cancel call")
+    ASRT(CBQ_Cancel(&handles[38]), "Failed to cancel call")
+
+    ASRT(CBQ_ExecBatch(&queue, 2, &executed, NULL, NULL), "Failed to exec batch")
+    printf("Executed by batch over tombstones: " SZ_PRTF " of 2\n", executed);
+
+    /* zero budget gives one step of CBQ_EXEC_FOR_CHECK_STEP calls */
+    ASRT(CBQ_ExecFor(&queue, 0, &executed, &size, NULL, NULL), "Failed to exec for budget")
+    printf("Executed and remaining calls: " SZ_PRTF " of 34\n", executed + size);
+    ASRT(CBQ_ExecAll(&queue, &executed, NULL, NULL), "Failed to exec all")
+
+    /* timeouts are cancellable only with heap or wheel */
+    ASRT(CBQ_SetTimeoutNs(&queue, 1000000000ULL, &queue, CB_0_Args, 0, NULL, &handles[0]) != CBQ_ERR_TIMERS_NOT_ATTACHED, "Timers must be required")
+
+    ASRT(CBQ_DeadlineHeapInit(&heap, 0, NULL), "Failed to init heap")
+    ASRT(CBQ_QueueAttachDeadlines(&queue, &heap), "Failed to attach heap")
+
+    /* request timeouts which are almost always canceled */
+    for (i = 0; i < 1000; i++)
+        ASRT(CBQ_SetTimeoutNs(&queue, 1000000000ULL, &queue, timerCountCB, 1, (CBQArg_t[]) {{.pVar = &fired}}, &handles[i]), "Failed to set timeout")
+    for (i = 0; i < 1000; i++)
+        ASRT(CBQ_Cancel(&handles[i]), "Failed to cancel timeout")
+
+    ASRT(CBQ_DeadlineHeapGetCount(&heap, &pending), "Failed to get count")
+    CBQ_GetSize(&queue, &size);
+    printf("Pending timeouts: " SZ_PRTF " of 0, calls: " SZ_PRTF " of 0\n", pending, size);
+
+    ASRT(CBQ_QueueAttachDeadlines(&queue, NULL), "Failed to detach heap")
+    ASRT(CBQ_DeadlineHeapFree(&heap), "Failed to free heap")
+    ASRT(CBQ_QueueFree(&queue), "Failed to free queue")
+}
@@ -21,6 +21,14 @@
     #include "cbqueue.h"
     #include "cbqversion.h"
     #include "cbqcallbacks.h"
+    #include "cbqrecords.h"
+    #include "cbqpool.h"
+    #include "cbqspsc.h"
+    #include "cbqmpsc.h"
+    #include "cbqmpmc.h"
+    #include "cbqexecutor.h"
+    #include "cbqscheduler.h"
+    #include "cbqtimer.h"
 
     #define CBQ_T_EXPLORE_VERSION() \
         CBQ_T_VerIdInfo(CBQ_CUR_VERSION)
@@ -34,6 +42,24 @@
     void CBQ_T_SetTimeout(void);
     void CBQ_T_VerIdInfo(int);
     void CBQ_T_ArgsTest(void);
+    void CBQ_T_RecordsTest(void);
+    void CBQ_T_AllocatorTest(void);
+    void CBQ_T_AutoShrinkTest(void);
+    void CBQ_T_SpscTest(void);
+    void CBQ_T_MpscTest(void);
+    void CBQ_T_MpmcTest(void);
+    void CBQ_T_ExecutorTest(void);
+    void CBQ_T_SchedulerTest(void);
+    void CBQ_T_ExecWaitTest(void);
+    void CBQ_T_ExecBatchTest(void);
+    void CBQ_T_ExecForTest(void);
+    void CBQ_T_PushBatchTest(void);
+    void CBQ_T_PushReserveTest(void);
+    void CBQ_T_TimerWheelTest(void);
+    void CBQ_T_SetTimeoutNsTest(void);
+    void CBQ_T_DeadlineHeapTest(void);
+    void CBQ_T_SetIntervalTest(void);
+    void CBQ_T_CancelTest(void);
 
     #ifdef CBQ_ALLOW_V2_METHODS
     void CBQ_T_CopyTest(void);
@@ -42,6 +68,10 @@
     void CBQ_T_SkipTest(void);
     #endif
 
+    #ifdef CBQ_ARGS_POOL
+    void CBQ_T_ArgsPoolTest(void);
+    #endif
+
 #endif // CBQTEST_H
 
 
@@ -0,0 +1,727 @@
+#include "cbqbuildconf.h"
+#include "cbqdebug.h"
+#include "cbqtimer.h"
+#include "cbqlocal.h"
+#include "cbqcontainer.h"
+
+#define TW_SLOT_MASK    (CBQ_TW_SLOTS - 1)
+#define TW_RANGE        (1ULL << (CBQ_TW_SLOT_BITS * CBQ_TW_LEVELS))
+
+#define DH_ARITY        4
+#define DH_NO_ID        ((size_t) -1)
+#define DH_PARENT(ID)   (((ID) - 1) / DH_ARITY)
+#define DH_CHILD(ID)    ((ID) * DH_ARITY + 1)
+
+struct CBQTimer_t {
+    /* slot list of wheel (pprev is NULL when timer is not pending in wheel) */
+    CBQTimer_t*     next;
+    CBQTimer_t**    pprev;
+    unsigned long long expiry;
+
+    /* place in deadline heap (DH_NO_ID when timer is not pending in heap) */
+    size_t          heapId;
+    CBQTicks_t      deadline;
+
+    /* periodic timer (0 period for one-shot), deadlines are anchored to first one */
+    CBQTicks_t      period;
+    int             policy;
+
+    unsigned int    gen;
+
+    CBQueue_t*      targetQueue;
+    QCallback       func;
+    unsigned int    argc;
+    unsigned int    capacity;
+    union {
+        CBQArg_t    inl[CBQ_INLINE_ARGS];
+        CBQArg_t*   ext;
+    } args;
+};
+
+#define TIMER_ARGS(TIMER) \
+    ((TIMER)->capacity <= CBQ_INLINE_ARGS? (TIMER)->args.inl : (TIMER)->args.ext)
+
+static void CBQ_timerLink__(CBQTimerWheel_t* wheel, CBQTimer_t* timer);
+static void CBQ_timerUnlink__(CBQTimer_t* timer);
+static unsigned long long CBQ_wheelTick__(const CBQTimerWheel_t* wheel, CBQTicks_t now, unsigned long long delayNs);
+static void CBQ_heapPlace__(CBQDeadlineHeap_t* heap, CBQTimer_t* timer, size_t id);
+static void CBQ_heapRemove__(CBQDeadlineHeap_t* heap, size_t id);
+static int CBQ_timerAdd__(CBQTimerWheel_t* wheel, CBQTicks_t deadline, CBQTicks_t period, int policy, CBQueue_t* targetQueue,
+                          QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+static int CBQ_deadlineAdd__(CBQDeadlineHeap_t* heap, CBQTicks_t deadline, CBQTicks_t period, int policy, CBQueue_t* targetQueue,
+                             QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+
+/* ---------------- Timers nodes ---------------- */
+static int CBQ_poolInit__(CBQTimerPool_t* pool, const CBQAllocator_t* allocator)
+{
+    if (allocator == NULL)
+        pool->allocator = (CBQAllocator_t) {CBQ_defAlloc__, CBQ_defResize__, CBQ_defRelease__, NULL, CBQ_defAllocZeroed__};
+    else if (allocator->alloc == NULL || allocator->resize == NULL || allocator->release == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    else
+        pool->allocator = *allocator;
+
+    pool->freeTimers = NULL;
+    return 0;
+}
+
+/* Frees list of nodes linked by next */
+static void CBQ_poolFreeList__(CBQTimerPool_t* pool, CBQTimer_t* timer)
+{
+    CBQTimer_t* next;
+
+    for (; timer != NULL; timer = next) {
+        next = timer->next;
+        if (timer->capacity > CBQ_INLINE_ARGS)
+            CBQ_QMEMFREE(pool, timer->args.ext, sizeof(CBQArg_t) * timer->capacity);
+        CBQ_QMEMFREE(pool, timer, sizeof(CBQTimer_t));
+    }
+}
+
+/* Takes node with copy of call, node is not pending anywhere */
+static int CBQ_poolTake__(CBQTimerPool_t* pool, CBQTimer_t** timerOut, CBQueue_t* targetQueue,
+                          QCallback func, unsigned int argc, const CBQArg_t* args)
+{
+    CBQTimer_t* timer;
+    CBQArg_t* newArgs;
+
+    if (pool->freeTimers != NULL) {
+        timer = pool->freeTimers;
+        pool->freeTimers = timer->next;
+    } else {
+        timer = (CBQTimer_t*) CBQ_QMALLOC(pool, sizeof(CBQTimer_t));
+        if (timer == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        timer->gen = 0;
+        timer->capacity = CBQ_INLINE_ARGS;
+    }
+
+    /* args storage grows only (node is reused) */
+    if (argc > timer->capacity) {
+        if (timer->capacity > CBQ_INLINE_ARGS)
+            newArgs = (CBQArg_t*) CBQ_QREALLOC(pool, timer->args.ext, sizeof(CBQArg_t) * timer->capacity, sizeof(CBQArg_t) * argc);
+        else
+            newArgs = (CBQArg_t*) CBQ_QMALLOC(pool, sizeof(CBQArg_t) * argc);
+
+        if (newArgs == NULL) {
+            timer->next = pool->freeTimers;
+            pool->freeTimers = timer;
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+        }
+        timer->args.ext = newArgs;
+        timer->capacity = argc;
+    }
+
+    if (argc)
+        CBQ_copyArgs__(args, TIMER_ARGS(timer), argc);
+
+    timer->argc = argc;
+    timer->func = func;
+    timer->targetQueue = targetQueue;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->heapId = DH_NO_ID;
+    timer->period = 0;
+
+    *timerOut = timer;
+    return 0;
+}
+
+/* Node keeps its args buffer in free list, handles of it become stale */
+static void CBQ_poolRelease__(CBQTimerPool_t* pool, CBQTimer_t* timer)
+{
+    timer->gen++;
+    timer->pprev = NULL;
+    timer->heapId = DH_NO_ID;
+    timer->next = pool->freeTimers;
+    pool->freeTimers = timer;
+}
+
+static int CBQ_timerPush__(CBQTimer_t* timer)
+{
+    if (timer->argc)
+        return CBQ_PushOnlyVP(timer->targetQueue, timer->func, timer->argc, TIMER_ARGS(timer));
+    else
+        return CBQ_PushVoid(timer->targetQueue, timer->func);
+}
+
+/* Period in timer ticks, it is never 0 for periodic timer */
+static int CBQ_periodTicks__(unsigned long long periodNs, int policy, CBQTicks_t* period)
+{
+    if (!periodNs || (policy != CBQ_IP_SKIP && policy != CBQ_IP_CATCH_UP))
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    *period = CBQ_NS_TO_TICKS(periodNs);
+    if (*period < 1)
+        *period = 1;
+
+    return 0;
+}
+
+static void CBQ_setHandle__(CBQTimerHandle_t* handle, CBQTimer_t* timer)
+{
+    if (handle != NULL) {
+        handle->timer = timer;
+        handle->gen = timer->gen;
+    }
+}
+
+/* ---------------- Timer wheel ---------------- */
+int CBQ_TimerWheelInit(CBQTimerWheel_t* wheel, unsigned long long tickNs, const CBQAllocator_t* allocator)
+{
+    CBQTimerWheel_t iniWheel = {
+        .tickNs = tickNs < CBQ_NS_P_TIC? CBQ_NS_P_TIC : tickNs,
+        .curTick = 0,
+        .count = 0,
+        .slots = {{NULL}}
+    };
+    int errSt;
+
+    if (wheel == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (wheel->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    if (tickNs < 1)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    errSt = CBQ_poolInit__(&iniWheel.pool, allocator);
+    if (errSt)
+        return errSt;
+
+    iniWheel.startTime = CBQ_TICKS_TO_NS(CBQ_FRESHTICKS());
+
+    iniWheel.initSt = CBQ_IN_INITED;
+    *wheel = iniWheel;
+
+    CBQ_MSGPRINT("Timer wheel initialized");
+    return 0;
+}
+
+int CBQ_TimerWheelFree(CBQTimerWheel_t* wheel)
+{
+    unsigned int level, slot;
+
+    BASE_ERR_CHECK(wheel);
+
+    for (level = 0; level < CBQ_TW_LEVELS; level++)
+        for (slot = 0; slot < CBQ_TW_SLOTS; slot++)
+            CBQ_poolFreeList__(&wheel->pool, wheel->slots[level][slot]);
+    CBQ_poolFreeList__(&wheel->pool, wheel->pool.freeTimers);
+
+    wheel->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("Timer wheel freed");
+    return 0;
+}
+
+/* Wheel tick of time with delay (rounded up, so timer never fires early) */
+static unsigned long long CBQ_wheelTick__(const CBQTimerWheel_t* wheel, CBQTicks_t now, unsigned long long delayNs)
+{
+    const unsigned long long elapsed = CBQ_TICKS_TO_NS(now) - wheel->startTime + delayNs;
+
+    return (elapsed + wheel->tickNs - 1) / wheel->tickNs;
+}
+
+/* Level of timer is the first one, which range covers time to expiry */
+static void CBQ_timerLink__(CBQTimerWheel_t* wheel, CBQTimer_t* timer)
+{
+    unsigned long long expiry = timer->expiry;
+    unsigned int level = 0;
+    CBQTimer_t** slot;
+
+    if (expiry - wheel->curTick >= TW_RANGE)
+        expiry = wheel->curTick + TW_RANGE - 1;
+
+    while (level < CBQ_TW_LEVELS - 1 && expiry - wheel->curTick >= 1ULL << (CBQ_TW_SLOT_BITS * (level + 1)))
+        level++;
+
+    slot = &wheel->slots[level][(expiry >> (CBQ_TW_SLOT_BITS * level)) & TW_SLOT_MASK];
+
+    timer->next = *slot;
+    if (*slot != NULL)
+        (*slot)->pprev = &timer->next;
+    *slot = timer;
+    timer->pprev = slot;
+}
+
+static void CBQ_timerUnlink__(CBQTimer_t* timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL)
+        timer->next->pprev = timer->pprev;
+    timer->pprev = NULL;
+}
+
+int CBQ_TimerAdd(CBQTimerWheel_t* wheel, unsigned long long delayNs, CBQueue_t* targetQueue,
+                 QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    return CBQ_timerAdd__(wheel, CBQ_FRESHTICKS() + CBQ_NS_TO_TICKS(delayNs), 0, 0, targetQueue, func, argc, args, handle);
+}
+
+int CBQ_TimerAddPeriodic(CBQTimerWheel_t* wheel, unsigned long long periodNs, int policy, CBQueue_t* targetQueue,
+                         QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    CBQTicks_t period;
+    int errSt;
+
+    errSt = CBQ_periodTicks__(periodNs, policy, &period);
+    if (errSt)
+        return errSt;
+
+    return CBQ_timerAdd__(wheel, CBQ_FRESHTICKS() + period, period, policy, targetQueue, func, argc, args, handle);
+}
+
+/* Wheel tick of deadline (rounded up), wheel may lag behind current time,
+ * but timer is never placed into passed slot
+ */
+static void CBQ_timerSetExpiry__(CBQTimerWheel_t* wheel, CBQTimer_t* timer)
+{
+    timer->expiry = CBQ_wheelTick__(wheel, timer->deadline, 0);
+    if (timer->expiry <= wheel->curTick)
+        timer->expiry = wheel->curTick + 1;
+}
+
+static int CBQ_timerAdd__(CBQTimerWheel_t* wheel, CBQTicks_t deadline, CBQTicks_t period, int policy, CBQueue_t* targetQueue,
+                          QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    CBQTimer_t* timer;
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(wheel);
+    BASE_ERR_CHECK(targetQueue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (argc && args == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    #endif
+
+    errSt = CBQ_poolTake__(&wheel->pool, &timer, targetQueue, func, argc, args);
+    if (errSt)
+        return errSt;
+
+    timer->deadline = deadline;
+    timer->period = period;
+    timer->policy = policy;
+    CBQ_timerSetExpiry__(wheel, timer);
+
+    CBQ_timerLink__(wheel, timer);
+    wheel->count++;
+
+    CBQ_setHandle__(handle, timer);
+
+    CBQ_MSGPRINT("Timer is added");
+    return 0;
+}
+
+int CBQ_TimerCancel(CBQTimerWheel_t* wheel, CBQTimerHandle_t* handle)
+{
+    OPT_BASE_ERR_CHECK(wheel);
+
+    if (handle == NULL || handle->timer == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    /* node is never freed before wheel, so stale handle just has other generation */
+    if (handle->timer->gen != handle->gen || handle->timer->pprev == NULL)
+        return CBQ_ERR_HANDLE_IS_STALE;
+
+    CBQ_timerUnlink__(handle->timer);
+    CBQ_poolRelease__(&wheel->pool, handle->timer);
+    wheel->count--;
+
+    handle->timer = NULL;
+
+    CBQ_MSGPRINT("Timer is canceled");
+    return 0;
+}
+
+static int CBQ_timerExpire__(CBQTimerWheel_t* wheel, CBQTimer_t* timer, CBQTicks_t now)
+{
+    int errSt;
+
+    errSt = CBQ_timerPush__(timer);
+    if (errSt) {
+        /* next advance tries again */
+        timer->expiry = wheel->curTick + 1;
+        CBQ_timerLink__(wheel, timer);
+        return errSt;
+    }
+
+    /* periodic timer is linked again with the same node and args */
+    if (timer->period) {
+        timer->deadline = CBQ_NEXT_DEADLINE(timer->deadline, timer->period, timer->policy, now);
+        CBQ_timerSetExpiry__(wheel, timer);
+        CBQ_timerLink__(wheel, timer);
+        return 0;
+    }
+
+    CBQ_poolRelease__(&wheel->pool, timer);
+    wheel->count--;
+
+    return 0;
+}
+
+int CBQ_TimerWheelAdvance(CBQTimerWheel_t* wheel, size_t* movedCount)
+{
+    unsigned long long nowTick, tick;
+    unsigned int level;
+    CBQTimer_t* timer, * next;
+    CBQTicks_t now;
+    size_t moved = 0;
+    int errSt = 0, pushSt;
+
+    OPT_BASE_ERR_CHECK(wheel);
+
+    now = CBQ_FRESHTICKS();
+    nowTick = CBQ_wheelTick__(wheel, now, 0);
+
+    while (wheel->curTick < nowTick) {
+
+        /* empty wheel just jumps to current time */
+        if (!wheel->count) {
+            wheel->curTick = nowTick;
+            break;
+        }
+
+        wheel->curTick++;
+
+        /* cascade upper levels slots, which turn is begun */
+        for (tick = wheel->curTick, level = 1; level < CBQ_TW_LEVELS && !(tick & TW_SLOT_MASK); level++) {
+            tick >>= CBQ_TW_SLOT_BITS;
+
+            timer = wheel->slots[level][tick & TW_SLOT_MASK];
+            wheel->slots[level][tick & TW_SLOT_MASK] = NULL;
+
+            for (; timer != NULL; timer = next) {
+                next = timer->next;
+                CBQ_timerLink__(wheel, timer);
+            }
+        }
+
+        /* due timers (list is detached, because failed pushes are linked again) */
+        timer = wheel->slots[0][wheel->curTick & TW_SLOT_MASK];
+        wheel->slots[0][wheel->curTick & TW_SLOT_MASK] = NULL;
+
+        for (; timer != NULL; timer = next) {
+            next = timer->next;
+            timer->pprev = NULL;
+
+            pushSt = CBQ_timerExpire__(wheel, timer, now);
+            if (!pushSt)
+                moved++;
+            else if (!errSt)
+                errSt = pushSt;     // first push error is returned
+        }
+    }
+
+    if (movedCount != NULL)
+        *movedCount = moved;
+
+    return errSt;
+}
+
+int CBQ_TimerWheelGetCount(const CBQTimerWheel_t* wheel, size_t* count)
+{
+    OPT_BASE_ERR_CHECK(wheel);
+
+    if (count == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *count = wheel->count;
+    return 0;
+}
+
+/* ---------------- Deadline heap ---------------- */
+int CBQ_DeadlineHeapInit(CBQDeadlineHeap_t* heap, size_t initCapacity, const CBQAllocator_t* allocator)
+{
+    CBQDeadlineHeap_t iniHeap = {
+        .heap = NULL,
+        .count = 0,
+        .capacity = initCapacity
+    };
+    int errSt;
+
+    if (heap == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (heap->initSt == CBQ_IN_INITED)
+        return CBQ_ERR_ALREADY_INITED;
+
+    errSt = CBQ_poolInit__(&iniHeap.pool, allocator);
+    if (errSt)
+        return errSt;
+
+    if (initCapacity) {
+        iniHeap.heap = (CBQTimer_t**) CBQ_QMALLOC(&iniHeap.pool, sizeof(CBQTimer_t*) * initCapacity);
+        if (iniHeap.heap == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+
+    iniHeap.initSt = CBQ_IN_INITED;
+    *heap = iniHeap;
+
+    CBQ_MSGPRINT("Deadline heap initialized");
+    return 0;
+}
+
+int CBQ_DeadlineHeapFree(CBQDeadlineHeap_t* heap)
+{
+    size_t id;
+
+    BASE_ERR_CHECK(heap);
+
+    for (id = 0; id < heap->count; id++)
+        heap->heap[id]->next = id + 1 < heap->count? heap->heap[id + 1] : NULL;
+
+    if (heap->count)
+        CBQ_poolFreeList__(&heap->pool, heap->heap[0]);
+    CBQ_poolFreeList__(&heap->pool, heap->pool.freeTimers);
+
+    if (heap->capacity)
+        CBQ_QMEMFREE(&heap->pool, heap->heap, sizeof(CBQTimer_t*) * heap->capacity);
+
+    heap->initSt = CBQ_IN_FREE;
+
+    CBQ_MSGPRINT("Deadline heap freed");
+    return 0;
+}
+
+/* Places timer into hole at id, hole is moved up or down to keep heap order */
+static void CBQ_heapPlace__(CBQDeadlineHeap_t* heap, CBQTimer_t* timer, size_t id)
+{
+    size_t child, last, minId;
+
+    /* sift up */
+    while (id && heap->heap[DH_PARENT(id)]->deadline > timer->deadline) {
+        heap->heap[id] = heap->heap[DH_PARENT(id)];
+        heap->heap[id]->heapId = id;
+        id = DH_PARENT(id);
+    }
+
+    /* sift down, minimal child of 4 is taken */
+    while ((child = DH_CHILD(id)) < heap->count) {
+        last = child + DH_ARITY < heap->count? child + DH_ARITY : heap->count;
+
+        for (minId = child++; child < last; child++)
+            if (heap->heap[child]->deadline < heap->heap[minId]->deadline)
+                minId = child;
+
+        if (heap->heap[minId]->deadline >= timer->deadline)
+            break;
+
+        heap->heap[id] = heap->heap[minId];
+        heap->heap[id]->heapId = id;
+        id = minId;
+    }
+
+    heap->heap[id] = timer;
+    timer->heapId = id;
+}
+
+/* Hole of removed timer is filled by the last one */
+static void CBQ_heapRemove__(CBQDeadlineHeap_t* heap, size_t id)
+{
+    CBQTimer_t* last;
+
+    heap->heap[id]->heapId = DH_NO_ID;
+    last = heap->heap[--heap->count];
+
+    if (id != heap->count)
+        CBQ_heapPlace__(heap, last, id);
+}
+
+int CBQ_DeadlineAdd(CBQDeadlineHeap_t* heap, unsigned long long delayNs, CBQueue_t* targetQueue,
+                    QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    return CBQ_deadlineAdd__(heap, CBQ_FRESHTICKS() + CBQ_NS_TO_TICKS(delayNs), 0, 0, targetQueue, func, argc, args, handle);
+}
+
+int CBQ_DeadlineAddPeriodic(CBQDeadlineHeap_t* heap, unsigned long long periodNs, int policy, CBQueue_t* targetQueue,
+                            QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    CBQTicks_t period;
+    int errSt;
+
+    errSt = CBQ_periodTicks__(periodNs, policy, &period);
+    if (errSt)
+        return errSt;
+
+    return CBQ_deadlineAdd__(heap, CBQ_FRESHTICKS() + period, period, policy, targetQueue, func, argc, args, handle);
+}
+
+static int CBQ_deadlineAdd__(CBQDeadlineHeap_t* heap, CBQTicks_t deadline, CBQTicks_t period, int policy, CBQueue_t* targetQueue,
+                             QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle)
+{
+    CBQTimer_t* timer;
+    CBQTimer_t** newHeap;
+    size_t newCapacity;
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(heap);
+    BASE_ERR_CHECK(targetQueue);
+
+    #ifndef NO_VPARAM_CHECK
+    if (argc && args == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    #endif
+
+    if (heap->count == heap->capacity) {
+        newCapacity = heap->capacity? heap->capacity * 2 : DH_ARITY * 4;
+
+        if (heap->capacity)
+            newHeap = (CBQTimer_t**) CBQ_QREALLOC(&heap->pool, heap->heap, sizeof(CBQTimer_t*) * heap->capacity, sizeof(CBQTimer_t*) * newCapacity);
+        else
+            newHeap = (CBQTimer_t**) CBQ_QMALLOC(&heap->pool, sizeof(CBQTimer_t*) * newCapacity);
+
+        if (newHeap == NULL)
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+
+        heap->heap = newHeap;
+        heap->capacity = newCapacity;
+    }
+
+    errSt = CBQ_poolTake__(&heap->pool, &timer, targetQueue, func, argc, args);
+    if (errSt)
+        return errSt;
+
+    timer->deadline = deadline;
+    timer->period = period;
+    timer->policy = policy;
+
+    CBQ_heapPlace__(heap, timer, heap->count++);
+
+    CBQ_setHandle__(handle, timer);
+
+    CBQ_MSGPRINT("Deadline is added");
+    return 0;
+}
+
+int CBQ_DeadlineCancel(CBQDeadlineHeap_t* heap, CBQTimerHandle_t* handle)
+{
+    OPT_BASE_ERR_CHECK(heap);
+
+    if (handle == NULL || handle->timer == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (handle->timer->gen != handle->gen || handle->timer->heapId == DH_NO_ID)
+        return CBQ_ERR_HANDLE_IS_STALE;
+
+    CBQ_heapRemove__(heap, handle->timer->heapId);
+    CBQ_poolRelease__(&heap->pool, handle->timer);
+
+    handle->timer = NULL;
+
+    CBQ_MSGPRINT("Deadline is canceled");
+    return 0;
+}
+
+int CBQ_DeadlineHeapAdvance(CBQDeadlineHeap_t* heap, size_t* movedCount)
+{
+    CBQTicks_t now;
+    CBQTimer_t* timer;
+    size_t moved = 0;
+    int errSt = 0;
+
+    OPT_BASE_ERR_CHECK(heap);
+
+    now = CBQ_FRESHTICKS();
+
+    while (heap->count && heap->heap[0]->deadline <= now) {
+        timer = heap->heap[0];
+
+        errSt = CBQ_timerPush__(timer);
+        if (errSt)
+            break;
+
+        /* periodic timer just goes down from root with next deadline,
+         * catch-up timer is fired again in this advance while it is still due
+         */
+        if (timer->period) {
+            timer->deadline = CBQ_NEXT_DEADLINE(timer->deadline, timer->period, timer->policy, now);
+            CBQ_heapPlace__(heap, timer, 0);
+        } else {
+            CBQ_heapRemove__(heap, 0);
+            CBQ_poolRelease__(&heap->pool, timer);
+        }
+        moved++;
+    }
+
+    if (movedCount != NULL)
+        *movedCount = moved;
+
+    return errSt;
+}
+
+int CBQ_DeadlineHeapGetCount(const CBQDeadlineHeap_t* heap, size_t* count)
+{
+    OPT_BASE_ERR_CHECK(heap);
+
+    if (count == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    *count = heap->count;
+    return 0;
+}
+
+/* ---------------- Queue binding ---------------- */
+int CBQ_QueueAttachTimers(CBQueue_t* queue, CBQTimerWheel_t* wheel)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (wheel != NULL) {
+        BASE_ERR_CHECK(wheel);
+    }
+
+    queue->timers = wheel;
+    return 0;
+}
+
+int CBQ_QueueAttachDeadlines(CBQueue_t* queue, CBQDeadlineHeap_t* heap)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (heap != NULL) {
+        BASE_ERR_CHECK(heap);
+    }
+
+    queue->deadlines = heap;
+    return 0;
+}
+
+int CBQ_NextDeadline(const CBQueue_t* queue, unsigned long long* waitNs)
+{
+    CBQTicks_t now;
+    unsigned long long wait = 0;
+    int pending = 0;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (waitNs == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->status != CBQ_ST_EMPTY) {
+        *waitNs = 0;
+        return 0;
+    }
+
+    if (queue->deadlines != NULL && queue->deadlines->count) {
+        now = CBQ_FRESHTICKS();
+        if (queue->deadlines->heap[0]->deadline > now)
+            wait = CBQ_TICKS_TO_NS(queue->deadlines->heap[0]->deadline - now);
+        pending = 1;
+    }
+
+    /* wheel does not know exact deadline, so it is checked every tick */
+    if (queue->timers != NULL && queue->timers->count) {
+        if (!pending || wait > queue->timers->tickNs)
+            wait = queue->timers->tickNs;
+        pending = 1;
+    }
+
+    if (!pending)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    *waitNs = wait;
+    return 0;
+}
@@ -0,0 +1,126 @@
+#ifndef CBQTIMER_H
+#define CBQTIMER_H
+
+#include "cbqbuildconf.h"
+#include "cbqueue.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Timer wheel geometry: levels and slots of each level (as bits of wheel tick) */
+    #define CBQ_TW_LEVELS       4
+    #define CBQ_TW_SLOT_BITS    6
+    #define CBQ_TW_SLOTS        (1 << CBQ_TW_SLOT_BITS)
+
+    typedef struct CBQTimer_t CBQTimer_t;
+
+    /* Handle of pending timer, it becomes stale after expiry or cancel of timer */
+    typedef struct CBQTimerHandle_t CBQTimerHandle_t;
+    struct CBQTimerHandle_t {
+        CBQTimer_t*     timer;
+        unsigned int    gen;
+    };
+
+    /* Timers nodes (with args) of wheel or heap, they are reused by free list */
+    typedef struct CBQTimerPool_t CBQTimerPool_t;
+    struct CBQTimerPool_t {
+        CBQAllocator_t allocator;
+        CBQTimer_t* freeTimers;
+    };
+
+    /* Hierarchical timer wheel
+     * Time is counted in wheel ticks of tickNs ns. Level L keeps timers which expire
+     * in less than CBQ_TW_SLOTS^(L+1) wheel ticks, slot of timer is taken by bits of its expiry tick.
+     * When lower level makes full turn, next slot of upper level is cascaded down,
+     * so timers are moved only log(delay) times and due timers are found without scanning.
+     * Timers which are farther than whole wheel wait in last level and they are placed again on cascade.
+     * Add and cancel are O(1), timers nodes (with args) are reused by free list.
+     * On advance due calls are pushed into their target queues, call which cannot be pushed
+     * stays in wheel until next advance.
+     */
+    typedef struct CBQTimerWheel_t CBQTimerWheel_t;
+    struct CBQTimerWheel_t {
+        int initSt;
+
+        CBQTimerPool_t pool;
+
+        unsigned long long tickNs;
+        unsigned long long startTime;   // ns of timer methods clock
+        unsigned long long curTick;
+
+        size_t count;
+        CBQTimer_t* slots[CBQ_TW_LEVELS][CBQ_TW_SLOTS];
+    };
+
+    /* Deadline heap
+     * 4-ary min-heap of timers by exact deadline (in timer ticks, see CBQ_TIMER_METHODS).
+     * Add and cancel are O(log n) and earliest deadline is known at once, so event loop
+     * may sleep until it (see CBQ_NextDeadline) instead of polling of timers.
+     * On advance due calls are pushed into their target queues, advance stops on first call
+     * which cannot be pushed, it stays in heap until next advance.
+     */
+    typedef struct CBQDeadlineHeap_t CBQDeadlineHeap_t;
+    struct CBQDeadlineHeap_t {
+        int initSt;
+
+        CBQTimerPool_t pool;
+
+        CBQTimer_t** heap;
+        size_t count;
+        size_t capacity;
+    };
+
+/* tickNs is resolution of wheel, it is raised to resolution of timer methods (CBQ_TIMER_METHODS) */
+int CBQ_TimerWheelInit(CBQTimerWheel_t* wheel, unsigned long long tickNs, const CBQAllocator_t* allocator);
+/* Pending timers are dropped */
+int CBQ_TimerWheelFree(CBQTimerWheel_t* wheel);
+
+/* delay is in ns, handle may be NULL */
+int CBQ_TimerAdd(CBQTimerWheel_t* wheel, unsigned long long delayNs, CBQueue_t* targetQueue,
+                 QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+/* Periodic timer (see CBQ_SetInterval), it is fired on first wheel tick after each deadline */
+int CBQ_TimerAddPeriodic(CBQTimerWheel_t* wheel, unsigned long long periodNs, int policy, CBQueue_t* targetQueue,
+                         QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+int CBQ_TimerCancel(CBQTimerWheel_t* wheel, CBQTimerHandle_t* handle);
+
+/* Moves calls of due timers into their target queues, movedCount may be NULL */
+int CBQ_TimerWheelAdvance(CBQTimerWheel_t* wheel, size_t* movedCount);
+int CBQ_TimerWheelGetCount(const CBQTimerWheel_t* wheel, size_t* count);
+
+/* Heap storage grows by need from initCapacity (may be 0) */
+int CBQ_DeadlineHeapInit(CBQDeadlineHeap_t* heap, size_t initCapacity, const CBQAllocator_t* allocator);
+/* Pending timers are dropped */
+int CBQ_DeadlineHeapFree(CBQDeadlineHeap_t* heap);
+
+/* delay is in ns, handle may be NULL */
+int CBQ_DeadlineAdd(CBQDeadlineHeap_t* heap, unsigned long long delayNs, CBQueue_t* targetQueue,
+                    QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+/* Periodic timer (see CBQ_SetInterval), node with args is kept until cancel */
+int CBQ_DeadlineAddPeriodic(CBQDeadlineHeap_t* heap, unsigned long long periodNs, int policy, CBQueue_t* targetQueue,
+                            QCallback func, unsigned int argc, CBQArg_t* args, CBQTimerHandle_t* handle);
+int CBQ_DeadlineCancel(CBQDeadlineHeap_t* heap, CBQTimerHandle_t* handle);
+
+/* Moves calls of due timers into their target queues, movedCount may be NULL */
+int CBQ_DeadlineHeapAdvance(CBQDeadlineHeap_t* heap, size_t* movedCount);
+int CBQ_DeadlineHeapGetCount(const CBQDeadlineHeap_t* heap, size_t* count);
+
+/* SetTimeout of queue with attached wheel adds timer into wheel (instead of re-pushed frame call),
+ * batched exec methods of queue advance wheel once per batch. NULL wheel detaches it.
+ */
+int CBQ_QueueAttachTimers(CBQueue_t* queue, CBQTimerWheel_t* wheel);
+/* Same for deadline heap, SetTimeout uses heap when both of them are attached */
+int CBQ_QueueAttachDeadlines(CBQueue_t* queue, CBQDeadlineHeap_t* heap);
+
+/* Time in ns which event loop may sleep before next exec of queue:
+ * 0 when queue has calls or due timers, time to earliest deadline of attached heap,
+ * at most one wheel tick when attached wheel has timers.
+ * Returns CBQ_ERR_QUEUE_IS_EMPTY when there are no calls and no pending timers (sleep without limit).
+ */
+int CBQ_NextDeadline(const CBQueue_t* queue, unsigned long long* waitNs);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQTIMER_H
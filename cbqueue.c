@@ -4,8 +4,16 @@
 #include "cbqlocal.h"
 #include "cbqcontainer.h"
 #include "cbqcapacity.h"
+#include "cbqtimer.h"
 
 int CBQ_QueueInit(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t maxCapacityLimit, unsigned int customInitArgsCapacity)
+{
+    return CBQ_QueueInitWithAllocator(queue, capacity, incCapacityMode, maxCapacityLimit, customInitArgsCapacity, NULL);
+}
+
+/* allocator is copied into queue, NULL - default allocator */
+int CBQ_QueueInitWithAllocator(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t maxCapacityLimit, unsigned int customInitArgsCapacity,
+                               const CBQAllocator_t* allocator)
 {
     int errSt;
     CBQueue_t iniQueue = {
@@ -14,8 +22,19 @@ int CBQ_QueueInit(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t
         #endif
         .capacity = capacity,
         .incCapacity = INIT_INC_CAPACITY,
+        .argArena = NULL,
+        .argFreeSlots = NULL,
+        .argSlotsCount = 0,
+        .argFreeCount = 0,
+        .argSlotCap = 0,
         .rId = 0,
         .sId = 0,
+        .reserved = 0,
+        .readSeq = 0,
+        .storeGen = 0,
+        .cancelled = 0,
+        .timers = NULL,
+        .deadlines = NULL,
         .status = CBQ_ST_EMPTY
 
         #ifdef CBQD_SCHEME
@@ -30,9 +49,28 @@ int CBQ_QueueInit(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t
     if (queue->initSt == CBQ_IN_INITED)
         return CBQ_ERR_ALREADY_INITED;
 
+    if (allocator == NULL)
+        iniQueue.allocator = (CBQAllocator_t) {CBQ_defAlloc__, CBQ_defResize__, CBQ_defRelease__, NULL, CBQ_defAllocZeroed__};
+    else if (allocator->alloc == NULL || allocator->resize == NULL || allocator->release == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    else
+        iniQueue.allocator = *allocator;
+
     if (capacity < CBQ_QUEUE_MIN_CAPACITY || capacity > CBQ_QUEUE_MAX_CAPACITY)
         return CBQ_ERR_ARG_OUT_OF_RANGE;
 
+    #ifdef CBQ_POW2_CAPACITY
+    capacity = iniQueue.capacity = CBQ_roundUpPow2__(capacity);
+    if (incCapacityMode == CBQ_SM_LIMIT && maxCapacityLimit)
+        maxCapacityLimit = CBQ_roundDownPow2__(maxCapacityLimit);
+    #endif // CBQ_POW2_CAPACITY
+
+    #ifdef CBQ_CHUNKED_STORAGE
+    capacity = iniQueue.capacity = CBQ_roundUpChunks__(capacity);
+    if (incCapacityMode == CBQ_SM_LIMIT && maxCapacityLimit && maxCapacityLimit <= CBQ_QUEUE_MAX_CAPACITY)
+        maxCapacityLimit = CBQ_roundUpChunks__(maxCapacityLimit);
+    #endif // CBQ_CHUNKED_STORAGE
+
     if (customInitArgsCapacity) {
         if (customInitArgsCapacity < MIN_CAP_ARGS || customInitArgsCapacity > MAX_CAP_ARGS)
             return CBQ_ERR_ARG_OUT_OF_RANGE;
@@ -49,14 +87,12 @@ int CBQ_QueueInit(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t
     } else
         return CBQ_ERR_ARG_OUT_OF_RANGE;    // for incCapacityMode and/or maxCapacityLimit params
 
-    iniQueue.coArr = (CBQContainer_t*) CBQ_MALLOC( sizeof(CBQContainer_t) * capacity);
-    if (iniQueue.coArr == NULL)
-        return CBQ_ERR_MEM_ALLOC_FAILED;
-
-    /* Containers init */
-    errSt = CBQ_containersRangeInit__(iniQueue.coArr, iniQueue.initArgCap, capacity, REST_MEM);
-    if (errSt)
+    /* Containers storage init */
+    errSt = CBQ_storageInit__(&iniQueue, capacity);
+    if (errSt) {
+        CBQ_argArenaFree__(&iniQueue);
         return errSt;
+    }
 
     /* set init status */
     iniQueue.initSt = CBQ_IN_INITED;
@@ -79,16 +115,103 @@ int CBQ_QueueFree(CBQueue_t* queue)
         return CBQ_ERR_IS_BUSY;
     #endif // NO_EXCEPTIONS_OF_BUSY
 
-    /* free args data in containers */
-    CBQ_containersRangeFree__(queue->coArr, queue->capacity);
-
-    /* free containers data */
-    CBQ_MEMFREE(queue->coArr);
+    /* free args data in containers, containers data and args arena */
+    CBQ_storageFree__(queue);
+    CBQ_argArenaFree__(queue);
 
     queue->initSt = CBQ_IN_FREE;
 
     CBQ_MSGPRINT("Queue freed");
-    return 0;
+    return 0;
+}
+
+/* Stores call into free cell of id without publishing (bulk and zero-copy push methods) */
+static int CBQ_storeCall__(CBQueue_t* trustedQueue, size_t id, QCallback func, unsigned int argc, const CBQArg_t* args)
+{
+    CBQContainer_t* container = CBQ_CO_BY_ID(trustedQueue, id);
+    int errSt;
+
+    #ifdef CBQ_LAZY_INIT
+    if (CBQ_CO_IS_UNINITED(container)) {
+        errSt = CBQ_containerLazyInit__(trustedQueue, container);
+        if (errSt)
+            return errSt;
+    }
+    #endif // CBQ_LAZY_INIT
+
+    if (argc > container->capacity) {
+        errSt = CBQ_changeArgsCapacity__(trustedQueue, container, argc, 0);
+        if (errSt)
+            return errSt;
+    }
+
+    /* args are not copied on reserve */
+    if (argc && args != NULL)
+        CBQ_copyArgs__(args, CBQ_CO_ARGS(container), argc);
+
+    container->argc = argc;
+    container->func = func;
+    container->gen = trustedQueue->storeGen;
+
+    #ifdef CBQD_SCHEME
+        container->label = trustedQueue->curLetter;
+        if (++trustedQueue->curLetter > 'Z')
+            trustedQueue->curLetter = 'A';
+    #endif // CBQD_SCHEME
+
+    return 0;
+}
+
+/* Cancelled calls (tombstones) are dropped from the front, returns 1 when queue becomes empty */
+static int CBQ_skipCancelled__(CBQueue_t* trustedQueue)
+{
+    while (CBQ_CO_BY_ID(trustedQueue, trustedQueue->rId)->func == NULL) {
+        trustedQueue->rId = CBQ_NEXT_ID(trustedQueue, trustedQueue->rId);
+        trustedQueue->readSeq++;
+        trustedQueue->cancelled--;
+        trustedQueue->status = CBQ_READ_STATUS(trustedQueue);
+
+        if (trustedQueue->status == CBQ_ST_EMPTY)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Tombstones at both ends of queue are dropped. During exec running call is kept in read cell,
+ * it is never cancelled (see CBQ_Cancel), so it stops the drop at the front.
+ */
+static void CBQ_dropCancelled__(CBQueue_t* trustedQueue)
+{
+    if (!trustedQueue->cancelled || trustedQueue->status == CBQ_ST_EMPTY || CBQ_skipCancelled__(trustedQueue))
+        return;
+
+    /* reserved call is stored into cell of store id */
+    if (trustedQueue->reserved || CBQ_CO_BY_ID(trustedQueue, CBQ_PREV_ID(trustedQueue, trustedQueue->sId))->func != NULL)
+        return;
+
+    /* read cell has live call now, so it stops the loop */
+    do {
+        trustedQueue->sId = CBQ_PREV_ID(trustedQueue, trustedQueue->sId);
+        trustedQueue->cancelled--;
+    } while (CBQ_CO_BY_ID(trustedQueue, CBQ_PREV_ID(trustedQueue, trustedQueue->sId))->func == NULL);
+
+    trustedQueue->status = CBQ_ST_STABLE;
+
+    /* sequence numbers of dropped calls are taken again by next pushes */
+    trustedQueue->storeGen++;
+}
+
+/* Number of tombstones in count cells from id */
+static size_t CBQ_countCancelled__(const CBQueue_t* trustedQueue, size_t id, size_t count)
+{
+    size_t cancelled = 0;
+
+    for (; count; count--, id = CBQ_NEXT_ID(trustedQueue, id))
+        if (CBQ_CO_BY_ID(trustedQueue, id)->func == NULL)
+            cancelled++;
+
+    return cancelled;
 }
 
 #ifdef CBQ_ALLOW_V2_METHODS
@@ -109,30 +232,53 @@ int CBQ_QueueCopy(CBQueue_t* restrict dest, const CBQueue_t* restrict src)
     if (dest->initSt == CBQ_IN_INITED)
         return CBQ_ERR_ALREADY_INITED;
 
-    CBQContainer_t* tmpCoArr = (CBQContainer_t*) CBQ_MALLOC(src->capacity * sizeof(CBQContainer_t));
-    if (tmpCoArr == NULL)
-        return CBQ_ERR_MEM_ALLOC_FAILED;
+    CBQueue_t tmpQueue = *src;
+    CBQContainer_t* container;
+
+    /* reserved call of source is not published, so copy has no reservation */
+    tmpQueue.reserved = 0;
 
-    CBQ_containersCopy__(src->coArr, tmpCoArr, src->capacity);
+    /* new arena for all slots of source by one allocation */
+    tmpQueue.argArena = tmpQueue.argFreeSlots = NULL;
+    tmpQueue.argSlotsCount = tmpQueue.argFreeCount = 0;
+    if (src->argSlotsCount > src->argFreeCount) {
+        if (CBQ_argArenaReserve__(&tmpQueue, src->argSlotsCount - src->argFreeCount))
+            return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
 
+    if (CBQ_storageCopy__(&tmpQueue, src)) {
+        CBQ_argArenaFree__(&tmpQueue);
+        return CBQ_ERR_MEM_ALLOC_FAILED;
+    }
+
+    /* only spilled args have own memory, inline args are copied with containers */
     for (size_t i = 0; i < src->capacity; i++) {
-        tmpCoArr[i].args = (CBQArg_t*) CBQ_MALLOC(src->coArr[i].capacity * sizeof(CBQArg_t));
+        container = CBQ_CO_AT(&tmpQueue, i);
+        if (CBQ_CO_IS_INLINE(container))
+            continue;
+
+        if (container->argsSt == CBQ_AST_ARENA)
+            container->args.ext = CBQ_argArenaTake__(&tmpQueue);
+        else
+            container->args.ext = CBQ_heapArgsAlloc__(&tmpQueue, container->capacity);
 
-        if (tmpCoArr[i].args == NULL) {
+        if (container->args.ext == NULL) {
         #ifdef REST_MEM
-            CBQ_containersRangeFree__(tmpCoArr, i);
-            CBQ_MEMFREE(tmpCoArr);
+            /* containers from failed one still point to src args */
+            for (; i < src->capacity; i++)
+                CBQ_CO_AT(&tmpQueue, i)->capacity = CBQ_INLINE_ARGS;
+            CBQ_storageFree__(&tmpQueue);
+            CBQ_argArenaFree__(&tmpQueue);
             return CBQ_ERR_MEM_BUT_RESTORED;
         #else // REST_MEM
             return CBQ_ERR_MEM_ALLOC_FAILED;
         #endif
         }
 
-        CBQ_copyArgs__(src->coArr[i].args, tmpCoArr[i].args, src->coArr[i].capacity);
+        CBQ_copyArgs__(CBQ_CO_AT(src, i)->args.ext, container->args.ext, container->capacity);
     }
 
-    *dest = *src;
-    dest->coArr = tmpCoArr;
+    *dest = tmpQueue;
 
     return 0;
 }
@@ -153,7 +299,12 @@ int CBQ_QueueCorrectMove(CBQueue_t* restrict dest, CBQueue_t* restrict src)
 
     *dest = *src;
 
+    #ifndef CBQ_CHUNKED_STORAGE
     src->coArr = NULL;
+    #else
+    src->coBlocks = NULL;
+    #endif // CBQ_CHUNKED_STORAGE
+    src->argArena = src->argFreeSlots = NULL;
     src->initSt = CBQ_IN_FREE;
 
     return 0;
@@ -176,6 +327,8 @@ int CBQ_QueueConcat(CBQueue_t* restrict dest, const CBQueue_t* restrict src)
         return CBQ_ERR_IS_BUSY;
     #endif // NO_EXCEPTIONS_OF_BUSY
 
+    if (dest->reserved)
+        return CBQ_ERR_IS_BUSY;
 
     commonSize = CBQ_getSizeByIndexes__(dest) + (srcSize = CBQ_getSizeByIndexes__(src));
 
@@ -185,13 +338,23 @@ int CBQ_QueueConcat(CBQueue_t* restrict dest, const CBQueue_t* restrict src)
             return errSt;
     }
 
-    for (size_t offset = src->rId, i = 0; i < srcSize; i++, offset = (offset + 1) % src->capacity) {
-        container = src->coArr + i;
-        errSt = CBQ_PushOnlyVP(dest, container->func, container->argc, container->args);
+    /* calls are published at once, so dest is not changed on error */
+    for (size_t offset = src->rId, sId = dest->sId, i = 0; i < srcSize; i++, offset = CBQ_NEXT_ID(src, offset), sId = CBQ_NEXT_ID(dest, sId)) {
+        container = CBQ_CO_BY_ID(src, offset);
+        errSt = CBQ_storeCall__(dest, sId, container->func, container->argc, CBQ_CO_ARGS(container));
         if (errSt)
             return errSt;
     }
 
+    if (srcSize) {
+        dest->sId = CBQ_ADD_ID(dest, dest->sId, srcSize);
+        dest->cancelled += src->cancelled;
+        dest->status = CBQ_STORED_STATUS(dest);
+    }
+
+    CBQ_MSGPRINT("Queue is concatenated");
+    CBQ_DRAWSCHEME_IN(dest);
+
     return 0;
 }
 
@@ -207,6 +370,10 @@ int CBQ_QueueTransfer(CBQueue_t* restrict dest, CBQueue_t* restrict src, size_t
         return CBQ_ERR_IS_BUSY;
     #endif // NO_EXCEPTIONS_OF_BUSY
 
+    /* reserved args storage of dest must not be moved by capacity changing */
+    if (dest->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     if (dest == src)
         return CBQ_ERR_SAME_QUEUE;
 
@@ -235,20 +402,26 @@ int CBQ_QueueTransfer(CBQueue_t* restrict dest, CBQueue_t* restrict src, size_t
     }
 
     for (CBQContainer_t* container; count; count--) {
-        container = src->coArr + src->rId;
-        errSt = CBQ_PushOnlyVP(dest, container->func, container->argc, container->args);
+        container = CBQ_CO_BY_ID(src, src->rId);
+
+        /* cancelled calls are not transferred */
+        if (container->func == NULL) {
+            src->cancelled--;
+            errSt = 0;
+        }
+        else if (container->argc)
+            errSt = CBQ_PushOnlyVP(dest, container->func, container->argc, CBQ_CO_ARGS(container));
+        else
+            errSt = CBQ_PushVoid(dest, container->func);
         if (errSt)
             return errSt;
 
-        src->rId++;
-        if (src->rId == src->capacity)
-            src->rId = 0;
+        src->rId = CBQ_NEXT_ID(src, src->rId);
+        src->readSeq++;
     }
 
-    if (src->rId == src->sId)
-        src->status = CBQ_ST_EMPTY;
-    else if (src->status == CBQ_ST_FULL) // still some leftover
-        src->status = CBQ_ST_STABLE;
+    src->status = CBQ_READ_STATUS(src); // still some leftover or empty
+    CBQ_dropCancelled__(src);
 
     return 0;
 }
@@ -270,20 +443,28 @@ int CBQ_Skip(CBQueue_t* queue, size_t count, const int cutBySize, const int reve
         count = size;
     }
 
-    if (!reverseOrder)
-        queue->rId = (queue->rId + count) % queue->capacity;    // at front
-    else {                                                      // at back
+    /* skipped tombstones are counted only when queue has them */
+    if (queue->cancelled)
+        queue->cancelled -= CBQ_countCancelled__(queue, reverseOrder? CBQ_ADD_ID(queue, queue->rId, size - count) : queue->rId, count);
+
+    if (!reverseOrder) {
+        queue->rId = CBQ_ADD_ID(queue, queue->rId, count);     // at front
+        queue->readSeq += count;
+    } else {                                                    // at back
+        #ifndef CBQ_POW2_CAPACITY
         if (queue->sId < count) {   // or sId < rId
             count -= queue->sId;
             queue->sId = queue->capacity;
         }
+        #endif // CBQ_POW2_CAPACITY
         queue->sId -= count;
+
+        /* sequence numbers of skipped calls are taken again, so their handles must not match */
+        queue->storeGen++;
     }
 
-    if (queue->rId == queue->sId)
-        queue->status = CBQ_ST_EMPTY;
-    else if (queue->status == CBQ_ST_FULL) // still some leftover
-        queue->status = CBQ_ST_STABLE;
+    queue->status = CBQ_READ_STATUS(queue); // still some leftover or empty
+    CBQ_dropCancelled__(queue);
 
     return 0;
 }
@@ -319,6 +500,10 @@ int CBQ_EqualizeArgsCapByCustom(CBQueue_t* queue, unsigned int customCapacity, c
         return CBQ_ERR_IS_BUSY;
     #endif // NO_EXCEPTIONS_OF_BUSY
 
+    /* store cell is taken by CBQ_PushReserve */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     if (customCapacity < MIN_CAP_ARGS || customCapacity > MAX_CAP_ARGS)
         return CBQ_ERR_ARG_OUT_OF_RANGE;
 
@@ -326,9 +511,9 @@ int CBQ_EqualizeArgsCapByCustom(CBQueue_t* queue, unsigned int customCapacity, c
 
     size = CBQ_getSizeByIndexes__(queue);
 
-    for (i = 0, offset = queue->rId; i < size; i++, offset = (offset + 1) % queue->capacity) { // % helps to loop ptr into capacity frames
+    for (i = 0, offset = queue->rId; i < size; i++, offset = CBQ_NEXT_ID(queue, offset)) { // loop ptr into capacity frames
 
-        container = queue->coArr + offset;
+        container = CBQ_CO_BY_ID(queue, offset);
 
         if (customCapacity < container->argc) {
             if (passNonModifiableArgs)
@@ -338,20 +523,20 @@ int CBQ_EqualizeArgsCapByCustom(CBQueue_t* queue, unsigned int customCapacity, c
         } else if (customCapacity == container->argc)
             continue;
         else {
-            errSt = CBQ_changeArgsCapacity__(container, customCapacity, 1);
+            errSt = CBQ_changeArgsCapacity__(queue, container, customCapacity, 1);
             if (errSt)
                 return errSt;
         }
     }
 
-    for (i = 0, offset = queue->sId; i < queue->capacity - size; i++, offset = (offset + 1) % queue->capacity) {
+    for (i = 0, offset = queue->sId; i < queue->capacity - size; i++, offset = CBQ_NEXT_ID(queue, offset)) {
 
-        container = queue->coArr + offset;
+        container = CBQ_CO_BY_ID(queue, offset);
 
         if (customCapacity == container->argc)
             continue;
         else {
-            errSt = CBQ_changeArgsCapacity__(container, customCapacity, 0);
+            errSt = CBQ_changeArgsCapacity__(queue, container, customCapacity, 0);
             if (errSt)
                 return errSt;
         }
@@ -368,10 +553,15 @@ __cdecl int CBQ_Push(CBQueue_t* queue, QCallback func, unsigned int varParamc, C
     int errSt;
     unsigned int argcAll;
     CBQContainer_t* container;
+    CBQArg_t* args;
 
     /* base error checking */
     OPT_BASE_ERR_CHECK(queue);
 
+    /* store cell is taken by CBQ_PushReserve */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     /* variable param check (optional), if only varParams pointer is null, vParamc not considered */
     #ifndef NO_VPARAM_CHECK
     if (varParams && !varParamc)
@@ -391,7 +581,15 @@ __cdecl int CBQ_Push(CBQueue_t* queue, QCallback func, unsigned int varParamc, C
     }
 
     /* set into container */
-    container = &queue->coArr[queue->sId];
+    container = CBQ_CO_BY_ID(queue, queue->sId);
+
+    #ifdef CBQ_LAZY_INIT
+    if (CBQ_CO_IS_UNINITED(container)) {
+        errSt = CBQ_containerLazyInit__(queue, container);
+        if (errSt)
+            return errSt;
+    }
+    #endif // CBQ_LAZY_INIT
 
     if (varParams)
         argcAll = stParamc + varParamc;
@@ -402,20 +600,23 @@ __cdecl int CBQ_Push(CBQueue_t* queue, QCallback func, unsigned int varParamc, C
 
         CBQ_MSGPRINT("Auto inc arg capacity...");
 
-        errSt = CBQ_changeArgsCapacity__(container, argcAll, 0);
+        errSt = CBQ_changeArgsCapacity__(queue, container, argcAll, 0);
         if (errSt)
             return errSt;
     }
 
+    args = CBQ_CO_ARGS(container);
+
     if (stParamc)
-        CBQ_copyArgs__(&stParams, container->args, stParamc);
+        CBQ_copyArgs__(&stParams, args, stParamc);
 
     /* in CB after static params are variable params*/
     if (varParams)
-        CBQ_copyArgs__(varParams, container->args + stParamc, varParamc);
+        CBQ_copyArgs__(varParams, args + stParamc, varParamc);
 
     container->argc = argcAll;
     container->func = func;
+    container->gen = queue->storeGen;
 
     /* debug for scheme */
     #ifdef CBQD_SCHEME
@@ -425,18 +626,218 @@ __cdecl int CBQ_Push(CBQueue_t* queue, QCallback func, unsigned int varParamc, C
     #endif // CBQD_SCHEME
 
     /* store index */
-    queue->sId++;
-    if (queue->sId == queue->capacity)
-        queue->sId = 0;
-
-    if (queue->sId == queue->rId)
-        queue->status = CBQ_ST_FULL;
-    else
-        queue->status = CBQ_ST_STABLE;
+    queue->sId = CBQ_NEXT_ID(queue, queue->sId);
+    queue->status = CBQ_STORED_STATUS(queue);
 
     CBQ_MSGPRINT("Queue is pushed");
     CBQ_DRAWSCHEME_IN(queue);
 
+    return 0;
+}
+
+int CBQ_PushBatch(CBQueue_t* queue, const CBQCall_t* calls, size_t count)
+{
+    size_t size, sId, i;
+    int errSt;
+
+    /* base error checking */
+    OPT_BASE_ERR_CHECK(queue);
+
+    /* store cell is taken by CBQ_PushReserve */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
+    if (calls == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+    if (!count)
+        return CBQ_ERR_ARG_OUT_OF_RANGE;
+
+    size = CBQ_getSizeByIndexes__(queue);
+    if (count > CBQ_QUEUE_MAX_CAPACITY - size)
+        return CBQ_ERR_MAX_CAPACITY_OVERFLOW;
+
+    /* one capacity incrementation for all calls */
+    if (size + count > queue->capacity) {
+
+        CBQ_MSGPRINT("Queue is full to push batch");
+
+        errSt = CBQ_incCapacity__(queue, size + count - queue->capacity, 0);
+        if (errSt)
+            return errSt;
+
+        CBQ_MSGPRINT("Capacity incrementation was automatic");
+    }
+
+    for (i = 0, sId = queue->sId; i < count; i++, sId = CBQ_NEXT_ID(queue, sId)) {
+
+        #ifndef NO_VPARAM_CHECK
+        if (calls[i].argc && calls[i].args == NULL)
+            return CBQ_ERR_ARG_NULL_POINTER;
+        #endif
+
+        errSt = CBQ_storeCall__(queue, sId, calls[i].func, calls[i].argc, calls[i].args);
+        if (errSt)
+            return errSt;
+    }
+
+    /* store index once */
+    queue->sId = CBQ_ADD_ID(queue, queue->sId, count);
+    queue->status = CBQ_STORED_STATUS(queue);
+
+    CBQ_MSGPRINT("Queue batch is pushed");
+    CBQ_DRAWSCHEME_IN(queue);
+
+    return 0;
+}
+
+int CBQ_PushReserve(CBQueue_t* queue, QCallback func, unsigned int argc, CBQArg_t** argsOut)
+{
+    int errSt;
+
+    /* base error checking */
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (argsOut == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
+    /* status check */
+    if (queue->status == CBQ_ST_FULL) {
+
+        CBQ_MSGPRINT("Queue is full to reserve");
+
+        errSt = CBQ_incCapacity__(queue, 0, 1);
+        if (errSt)
+            return errSt;
+
+        CBQ_MSGPRINT("Capacity incrementation was automatic");
+    }
+
+    errSt = CBQ_storeCall__(queue, queue->sId, func, argc, NULL);
+    if (errSt)
+        return errSt;
+
+    *argsOut = argc? CBQ_CO_ARGS(CBQ_CO_BY_ID(queue, queue->sId)) : NULL;
+    queue->reserved = 1;
+
+    CBQ_MSGPRINT("Queue store cell is reserved");
+    return 0;
+}
+
+int CBQ_PushCommit(CBQueue_t* queue)
+{
+    /* base error checking */
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (!queue->reserved)
+        return CBQ_ERR_NOT_RESERVED;
+
+    /* store index */
+    queue->sId = CBQ_NEXT_ID(queue, queue->sId);
+    queue->status = CBQ_STORED_STATUS(queue);
+    queue->reserved = 0;
+
+    CBQ_MSGPRINT("Queue is pushed");
+    CBQ_DRAWSCHEME_IN(queue);
+
+    return 0;
+}
+
+int CBQ_PushCancel(CBQueue_t* queue)
+{
+    /* base error checking */
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (!queue->reserved)
+        return CBQ_ERR_NOT_RESERVED;
+
+    /* cell is free again, its args storage is just reused by next push */
+    queue->reserved = 0;
+
+    CBQ_MSGPRINT("Queue store cell reservation is canceled");
+    return 0;
+}
+
+int CBQ_LastCallHandle(const CBQueue_t* queue, CBQHandle_t* handle)
+{
+    /* base error checking */
+    OPT_BASE_ERR_CHECK(queue);
+
+    if (handle == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    if (queue->status == CBQ_ST_EMPTY)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    handle->queue = (CBQueue_t*) queue;
+    handle->seq = queue->readSeq + CBQ_getSizeByIndexes__(queue) - 1;
+    handle->gen = CBQ_CO_BY_ID(queue, CBQ_PREV_ID(queue, queue->sId))->gen;
+    handle->timer = NULL;
+
+    return 0;
+}
+
+int CBQ_Cancel(CBQHandle_t* handle)
+{
+    CBQueue_t* queue;
+    CBQContainer_t* container;
+    CBQTimerHandle_t timer;
+    size_t offset;
+    int errSt;
+
+    if (handle == NULL || handle->queue == NULL)
+        return CBQ_ERR_ARG_NULL_POINTER;
+
+    queue = handle->queue;
+    OPT_BASE_ERR_CHECK(queue);
+
+    /* timeout is kept by attached heap or wheel (node of one of them is stale for other) */
+    if (handle->timer != NULL) {
+        timer = (CBQTimerHandle_t) {handle->timer, handle->gen};
+        errSt = CBQ_ERR_HANDLE_IS_STALE;
+
+        if (queue->deadlines != NULL)
+            errSt = CBQ_DeadlineCancel(queue->deadlines, &timer);
+        if (errSt == CBQ_ERR_HANDLE_IS_STALE && queue->timers != NULL)
+            errSt = CBQ_TimerCancel(queue->timers, &timer);
+
+        if (!errSt)
+            handle->queue = NULL;
+        return errSt;
+    }
+
+    /* call is found by its offset from read cell and checked by generation */
+    if (handle->seq < queue->readSeq)
+        return CBQ_ERR_HANDLE_IS_STALE;
+
+    offset = (size_t) (handle->seq - queue->readSeq);
+    if (offset >= CBQ_getSizeByIndexes__(queue))
+        return CBQ_ERR_HANDLE_IS_STALE;
+
+    container = CBQ_CO_BY_ID(queue, CBQ_ADD_ID(queue, queue->rId, offset));
+    if (container->gen != handle->gen || container->func == NULL)
+        return CBQ_ERR_HANDLE_IS_STALE;
+
+    /* running call is not cancelled */
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC && !offset)
+        return CBQ_ERR_HANDLE_IS_STALE;
+    #else
+    /* exec status is unknown, so call in read cell may be running */
+    if (!offset)
+        return CBQ_ERR_IS_BUSY;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    container->func = NULL;
+    queue->cancelled++;
+
+    CBQ_dropCancelled__(queue);
+
+    handle->queue = NULL;
+
+    CBQ_MSGPRINT("Call is canceled");
     return 0;
 }
 
@@ -448,6 +849,10 @@ int CBQ_PushOnlyVP(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQ
     /* base error checking */
     OPT_BASE_ERR_CHECK(queue);
 
+    /* store cell is taken by CBQ_PushReserve */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
+
     /* variable param check (optional), if only varParams pointer is null, vParamc not considered */
     #ifndef NO_VPARAM_CHECK
     if (varParams == NULL)
@@ -469,21 +874,30 @@ int CBQ_PushOnlyVP(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQ
     }
 
     /* set into container */
-    container = queue->coArr + queue->sId;  // container = &queue->coArr[queue->sId]
+    container = CBQ_CO_BY_ID(queue, queue->sId);
+
+    #ifdef CBQ_LAZY_INIT
+    if (CBQ_CO_IS_UNINITED(container)) {
+        errSt = CBQ_containerLazyInit__(queue, container);
+        if (errSt)
+            return errSt;
+    }
+    #endif // CBQ_LAZY_INIT
 
     if (varParamc > container->capacity) {
 
             CBQ_MSGPRINT("Auto inc arg capacity...");
 
-            errSt = CBQ_changeArgsCapacity__(container, varParamc, 0);
+            errSt = CBQ_changeArgsCapacity__(queue, container, varParamc, 0);
             if (errSt)
                 return errSt;
     }
 
-    CBQ_copyArgs__(varParams, container->args, varParamc);
+    CBQ_copyArgs__(varParams, CBQ_CO_ARGS(container), varParamc);
 
     container->argc = varParamc;
     container->func = func;
+    container->gen = queue->storeGen;
 
     /* debug for scheme */
     #ifdef CBQD_SCHEME
@@ -493,14 +907,8 @@ int CBQ_PushOnlyVP(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQ
     #endif // CBQD_SCHEME
 
     /* store index */
-    queue->sId++;
-    if (queue->sId == queue->capacity)
-        queue->sId = 0;
-
-    if (queue->sId == queue->rId)
-        queue->status = CBQ_ST_FULL;
-    else
-        queue->status = CBQ_ST_STABLE;
+    queue->sId = CBQ_NEXT_ID(queue, queue->sId);
+    queue->status = CBQ_STORED_STATUS(queue);
 
     CBQ_MSGPRINT("Queue is pushed");
     CBQ_DRAWSCHEME_IN(queue);
@@ -510,8 +918,14 @@ int CBQ_PushOnlyVP(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQ
 
 int CBQ_PushVoid(CBQueue_t* queue, QCallback func)
 {
+    CBQContainer_t* container;
+
     /* base error checking */
     OPT_BASE_ERR_CHECK(queue);
+
+    /* store cell is taken by CBQ_PushReserve */
+    if (queue->reserved)
+        return CBQ_ERR_IS_BUSY;
 
     /* status check */
     if (queue->status == CBQ_ST_FULL) {
@@ -527,25 +941,21 @@ int CBQ_PushVoid(CBQueue_t* queue, QCallback func)
     }
 
     /* set into container only func */
-    (queue->coArr + queue->sId)->func = func;
-    (queue->coArr + queue->sId)->argc = 0;
+    container = CBQ_CO_BY_ID(queue, queue->sId);
+    container->func = func;
+    container->argc = 0;
+    container->gen = queue->storeGen;
 
     /* debug for scheme */
     #ifdef CBQD_SCHEME
-        (queue->coArr + queue->sId)->label = queue->curLetter;
+        container->label = queue->curLetter;
         if (++queue->curLetter > 'Z')
             queue->curLetter = 'A';
     #endif // CBQD_SCHEME
 
     /* store index */
-    queue->sId++;
-    if (queue->sId == queue->capacity)
-        queue->sId = 0;
-
-    if (queue->sId == queue->rId)
-        queue->status = CBQ_ST_FULL;
-    else
-        queue->status = CBQ_ST_STABLE;
+    queue->sId = CBQ_NEXT_ID(queue, queue->sId);
+    queue->status = CBQ_STORED_STATUS(queue);
 
     CBQ_MSGPRINT("Queue is pushed");
     CBQ_DRAWSCHEME_IN(queue);
@@ -556,6 +966,8 @@ int CBQ_PushVoid(CBQueue_t* queue, QCallback func)
 int CBQ_Exec(CBQueue_t* queue, int* funcRetSt)
 {
     CBQContainer_t* container;
+    CBQArg_t* args;
+    CBQArg_t inlArgs[CBQ_INLINE_ARGS];
 
     OPT_BASE_ERR_CHECK(queue);
 
@@ -570,31 +982,52 @@ int CBQ_Exec(CBQueue_t* queue, int* funcRetSt)
     queue->execSt = CBQ_EST_EXEC;
     #endif // NO_EXCEPTIONS_OF_BUSY
 
+    CBQ_REFRESHTICKS();
+
+    if (queue->cancelled && CBQ_skipCancelled__(queue)) {
+        #ifndef NO_EXCEPTIONS_OF_BUSY
+        queue->execSt = CBQ_EST_NO_EXEC;
+        #endif // NO_EXCEPTIONS_OF_BUSY
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+    }
+
     /* inset from container and execute callback function */
-    container = queue->coArr + queue->rId;
+    container = CBQ_CO_BY_ID(queue, queue->rId);
+
+    /* Inline args are passed by local copy, because pushes from callback
+     * may move containers (with its inline area) during capacity changing
+     */
+    if (CBQ_CO_IS_INLINE(container)) {
+        if (container->argc)
+            CBQ_copyArgs__(container->args.inl, inlArgs, container->argc);
+        args = inlArgs;
+    } else
+        args = container->args.ext;
+
     if (funcRetSt == NULL)
-        container->func( (int) container->argc, container->args);
+        container->func( (int) container->argc, args);
     else
-        *funcRetSt = container->func( (int) container->argc, container->args);
+        *funcRetSt = container->func( (int) container->argc, args);
 
     #ifdef CBQD_SCHEME
-    queue->coArr[queue->rId].label = '-';
+    CBQ_CO_BY_ID(queue, queue->rId)->label = '-';
     #endif
 
     /* read index */
-    queue->rId++;
-    if (queue->rId == queue->capacity)
-        queue->rId = 0;
-
-    if (queue->rId == queue->sId)
-        queue->status = CBQ_ST_EMPTY;
-    else
-        queue->status = CBQ_ST_STABLE;
+    queue->rId = CBQ_NEXT_ID(queue, queue->rId);
+    queue->readSeq++;
+    queue->status = CBQ_READ_STATUS(queue);
 
     #ifndef NO_EXCEPTIONS_OF_BUSY
     /* now queue is free for executing */
     queue->execSt = CBQ_EST_NO_EXEC;
     #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* calls cancelled by callback may be left at the ends */
+    CBQ_dropCancelled__(queue);
+
+    if (queue->shrinkLowWater)
+        CBQ_autoShrink__(queue);
 
     CBQ_MSGPRINT("Queue is popped");
 
@@ -603,19 +1036,193 @@ int CBQ_Exec(CBQueue_t* queue, int* funcRetSt)
     return 0;
 }
 
+/* Due timers of attached wheel and heap are moved into their queues once per batch
+ * (failed pushes are retried later), timer checks of whole batch read time of advance
+ * or of refresh (cached timer methods)
+ */
+static void CBQ_advanceTimers__(CBQueue_t* queue)
+{
+    if (queue->timers == NULL && queue->deadlines == NULL) {
+        CBQ_REFRESHTICKS();
+        return;
+    }
+
+    if (queue->timers != NULL)
+        CBQ_TimerWheelAdvance(queue->timers, NULL);
+
+    if (queue->deadlines != NULL)
+        CBQ_DeadlineHeapAdvance(queue->deadlines, NULL);
+}
+
+/* Batch of calls after advance of timers, it is limited by executed calls and by passed cells */
+static int CBQ_execBatch__(CBQueue_t* queue, size_t maxCount, size_t maxCells, size_t* executedCount, CBQRetHook retHook, void* hookCtx)
+{
+    CBQContainer_t* container, * next;
+    CBQArg_t* args;
+    CBQArg_t inlArgs[CBQ_INLINE_ARGS];
+    size_t count = 0, cells = 0;
+    int retSt;
+
+    if (executedCount != NULL)
+        *executedCount = 0;
+
+    if (queue->status == CBQ_ST_EMPTY)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    if (queue->execSt == CBQ_EST_EXEC)
+        return CBQ_ERR_IS_BUSY;
+
+    queue->execSt = CBQ_EST_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    /* cancelled calls are passed without call and are not counted */
+    while (count < maxCount && cells < maxCells) {
+        /* container is taken by id every time: pushes from callback may move containers */
+        container = CBQ_CO_BY_ID(queue, queue->rId);
+
+        /* next container (and its spilled args) are pulled into cache while callback runs */
+        next = CBQ_CO_BY_ID(queue, CBQ_NEXT_ID(queue, queue->rId));
+        CBQ_PREFETCH(next);
+        if (!CBQ_CO_IS_INLINE(next))
+            CBQ_PREFETCH(next->args.ext);
+
+        if (container->func != NULL) {
+            if (CBQ_CO_IS_INLINE(container)) {
+                if (container->argc)
+                    CBQ_copyArgs__(container->args.inl, inlArgs, container->argc);
+                args = inlArgs;
+            } else
+                args = container->args.ext;
+
+            retSt = container->func( (int) container->argc, args);
+            if (retHook != NULL)
+                retHook(hookCtx, retSt);
+            count++;
+        } else
+            queue->cancelled--;
+
+        #ifdef CBQD_SCHEME
+        CBQ_CO_BY_ID(queue, queue->rId)->label = '-';
+        #endif
+
+        /* ids are stored after every call, because pushes from callback read them */
+        queue->rId = CBQ_NEXT_ID(queue, queue->rId);
+        queue->readSeq++;
+        cells++;
+
+        if (queue->rId == queue->sId) {
+            queue->status = CBQ_ST_EMPTY;
+            break;
+        }
+        queue->status = CBQ_ST_STABLE;
+    }
+
+    #ifndef NO_EXCEPTIONS_OF_BUSY
+    queue->execSt = CBQ_EST_NO_EXEC;
+    #endif // NO_EXCEPTIONS_OF_BUSY
+
+    CBQ_dropCancelled__(queue);
+
+    if (queue->shrinkLowWater)
+        CBQ_autoShrink__(queue);
+
+    if (executedCount != NULL)
+        *executedCount = count;
+
+    CBQ_MSGPRINT("Queue batch is executed");
+
+    CBQ_DRAWSCHEME_IN(queue);
+
+    return 0;
+}
+
+int CBQ_ExecBatch(CBQueue_t* queue, size_t maxCount, size_t* executedCount, CBQRetHook retHook, void* hookCtx)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    CBQ_advanceTimers__(queue);
+
+    return CBQ_execBatch__(queue, maxCount, SIZE_MAX, executedCount, retHook, hookCtx);
+}
+
+int CBQ_ExecAll(CBQueue_t* queue, size_t* executedCount, CBQRetHook retHook, void* hookCtx)
+{
+    OPT_BASE_ERR_CHECK(queue);
+
+    size_t size;
+
+    /* calls moved by due timers are counted too */
+    CBQ_advanceTimers__(queue);
+
+    size = CBQ_getSizeByIndexes__(queue);
+    return CBQ_execBatch__(queue, size, size, executedCount, retHook, hookCtx);
+}
+
+/* Monotonic time in ns (not affected by system time changes) */
+unsigned long long CBQ_monotonicNs__(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+#if CBQ_TIMER_METHODS == 3
+CBQ_THREAD_LOCAL CBQTicks_t CBQ_cachedTicks__ = 0;
+
+/* Coarse clock does not read hardware counter, its resolution is a kernel tick */
+unsigned long long CBQ_coarseNs__(void)
+{
+    struct timespec ts;
+
+    #ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    #else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    #endif // CLOCK_MONOTONIC_COARSE
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+#endif // CBQ_TIMER_METHODS
+
+int CBQ_ExecFor(CBQueue_t* queue, unsigned long long budgetNs, size_t* executedCount, size_t* remainCount, CBQRetHook retHook, void* hookCtx)
+{
+    const unsigned long long startTime = CBQ_monotonicNs__();
+    size_t count = 0, stepCount;
+    int errSt;
+
+    OPT_BASE_ERR_CHECK(queue);
+
+    do {
+        errSt = CBQ_ExecBatch(queue, CBQ_EXEC_FOR_CHECK_STEP, &stepCount, retHook, hookCtx);
+        count += stepCount;
+    } while (!errSt && queue->status != CBQ_ST_EMPTY && CBQ_monotonicNs__() - startTime < budgetNs);
+
+    if (executedCount != NULL)
+        *executedCount = count;
+    if (remainCount != NULL)
+        *remainCount = CBQ_getSizeByIndexes__(queue) - queue->cancelled;
+
+    return errSt;
+}
+
 int CBQ_Clear(CBQueue_t* queue)
 {
     OPT_BASE_ERR_CHECK(queue);
 
     /* To clear a queue, you can simply shift the pointers
      * to a common index and set the status of an empty queue.
+     * Sequence numbers go on, so handles of cleared calls are stale.
      */
+    queue->readSeq += CBQ_getSizeByIndexes__(queue);
+    queue->cancelled = 0;
     queue->rId = queue->sId = 0;
     queue->status = CBQ_ST_EMPTY;
+    queue->reserved = 0;
 
     #ifdef CBQD_SCHEME
     for (size_t i = 0; i < queue->capacity; i++)
-        queue->coArr[i].label = '-';
+        CBQ_CO_AT(queue, i)->label = '-';
     #endif // CBQD_SCHEME
     return 0;
 }
@@ -633,14 +1240,22 @@ int CBQ_GetSize(const CBQueue_t* queue, size_t* size)
 int CBQ_GetCapacityInBytes(const CBQueue_t* queue, size_t* byteCapacity)
 {
     size_t bCapacity;
+    const CBQContainer_t* container;
 
     OPT_BASE_ERR_CHECK(queue);
     if (byteCapacity == NULL)
         return CBQ_ERR_ARG_NULL_POINTER;
 
     bCapacity = sizeof(CBQueue_t) + queue->capacity * sizeof(CBQContainer_t);
-    for (size_t i = 0; i < queue->capacity; i++)
-        bCapacity += (size_t) queue->coArr[i].capacity * sizeof(CBQArg_t);
+    #ifdef CBQ_CHUNKED_STORAGE
+    bCapacity += queue->capacity / CBQ_CHUNK_CAPACITY * sizeof(CBQContainer_t*);
+    #endif // CBQ_CHUNKED_STORAGE
+    bCapacity += queue->argSlotsCount * queue->argSlotCap * sizeof(CBQArg_t);
+    for (size_t i = 0; i < queue->capacity; i++) {
+        container = CBQ_CO_AT(queue, i);
+        if (!CBQ_CO_IS_INLINE(container) && container->argsSt == CBQ_AST_HEAP)
+            bCapacity += (size_t) container->capacity * sizeof(CBQArg_t);
+    }
 
     *byteCapacity = bCapacity;
     return 0;
@@ -123,6 +123,49 @@
 
     typedef int (*QCallback) (int argc, CBQArg_t* args);
 
+    /* Call description for bulk push (args are copied into queue) */
+    typedef struct CBQCall_t CBQCall_t;
+    struct CBQCall_t {
+        QCallback       func;
+        unsigned int    argc;
+        CBQArg_t*       args;
+    };
+
+    /* Handle of pushed call or timeout (see CBQ_Cancel)
+     * Call is found by its sequence number in queue and is checked by generation,
+     * timeout of attached heap or wheel is kept by its timer node.
+     * Handle becomes stale after exec or cancel of call.
+     */
+    typedef struct CBQHandle_t CBQHandle_t;
+    struct CBQHandle_t {
+        struct CBQueue_t*   queue;
+        unsigned long long  seq;
+        unsigned int        gen;
+        struct CBQTimer_t*  timer;  // NULL for call in queue
+    };
+
+    /* Receives return status of each callback of batched exec */
+    typedef void (*CBQRetHook) (void* hookCtx, int funcRetSt);
+
+
+    /* ---------------- Allocator declaration ---------------- */
+
+    /* Memory methods which are used by queue for containers and args.
+     * ctx is passed into every method as first param (arena, heap handle, etc).
+     * Sizes of resized/released memory are the same as they were requested,
+     * so sized allocators (bump, per-thread arenas) need not to store them.
+     * release may do nothing, if memory of allocator is freed wholesale
+     * after CBQ_QueueFree. Allocator must not be changed while queue is inited.
+     */
+    typedef struct CBQAllocator_t CBQAllocator_t;
+    struct CBQAllocator_t {
+        void*   (*alloc)    (void* ctx, size_t size);
+        void*   (*resize)   (void* ctx, void* ptr, size_t oldSize, size_t newSize);
+        void    (*release)  (void* ctx, void* ptr, size_t size);
+        void*   ctx;
+        void*   (*allocZeroed) (void* ctx, size_t size);   // optional (NULL - alloc with zeroing)
+    };
+
 
     /* ---------------- Queue (main) structure declaration ---------------- */
 
@@ -143,19 +186,55 @@
         int     execSt;
         #endif // NO_EXCEPTIONS_OF_BUSY
 
+        /* memory methods of queue */
+        CBQAllocator_t allocator;
+
         /* containers */
+        #ifndef CBQ_CHUNKED_STORAGE
         struct  CBQContainer_t* C_ATTR coArr;
+        #else
+        struct  CBQContainer_t** C_ATTR coBlocks;   // map of containers blocks
+        #endif // CBQ_CHUNKED_STORAGE
         size_t  capacity;
         size_t  maxCapacityLimit;
         size_t  incCapacity;
         int     incCapacityMode;
         unsigned int initArgCap;
 
+        /* args arena (slots for init args capacity above inline area) */
+        CBQArg_t* argArena;
+        CBQArg_t* argFreeSlots;
+        size_t  argSlotsCount;
+        size_t  argFreeCount;
+        unsigned int argSlotCap;
+
+        /* auto shrink policy (see CBQ_SetAutoShrink) */
+        unsigned int shrinkLowWater;    // percent of capacity, 0 - policy is off
+        unsigned int shrinkHysteresis;
+        unsigned int lowWaterExecs;
+        size_t  shrinkMinCapacity;
+        long long shrinkInterval;       // in timer ticks (see CBQ_TIMER_METHODS)
+        long long lastShrinkTime;
+
         /* pointers */
         size_t  rId;
         size_t  sId;
         int     status;
 
+        /* store cell is taken by CBQ_PushReserve until commit or cancel */
+        int     reserved;
+
+        /* call handles (see CBQ_Cancel): sequence number of call in read cell
+         * and generation of stored calls (it is changed when calls are removed from the back)
+         */
+        unsigned long long readSeq;
+        unsigned int storeGen;
+        size_t  cancelled;  // tombstones in queue
+
+        /* attached timer wheel and deadline heap of SetTimeout (see cbqtimer.h) */
+        struct CBQTimerWheel_t* timers;
+        struct CBQDeadlineHeap_t* deadlines;
+
         /* debug */
         #ifdef CBQD_SCHEME
         int curLetter;
@@ -219,6 +298,10 @@
         CBQ_ERR_COUNT_NOT_FIT_IN_SIZE,
         CBQ_ERR_SAME_QUEUE,
         #endif
+        CBQ_ERR_THREAD_START_FAILED,
+        CBQ_ERR_NOT_RESERVED,
+        CBQ_ERR_HANDLE_IS_STALE,
+        CBQ_ERR_TIMERS_NOT_ATTACHED,
     };
 
     /* These enums choose in "changeTowards" param from ChangeCapacity method
@@ -232,9 +315,21 @@
         CBQ_DEC_CAPACITY
     };
 
+    /* Policies of periodic timers (SetInterval) when deadlines are missed (overrun)
+     * CBQ_IP_SKIP - missed periods are skipped, next call is at next deadline after current time;
+     * CBQ_IP_CATCH_UP - call is done for each missed period, one after another.
+     * Deadlines are always first deadline + N periods, so cadence has no drift.
+     */
+    enum CBQ_IntervalPolicies {
+        CBQ_IP_SKIP,
+        CBQ_IP_CATCH_UP
+    };
+
 
 /* ---------------- Base method sdeclaration ---------------- */
 int CBQ_QueueInit(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t maxCapacityLimit, unsigned int customInitArgsCapacity);
+int CBQ_QueueInitWithAllocator(CBQueue_t* queue, size_t capacity, int incCapacityMode, size_t maxCapacityLimit, unsigned int customInitArgsCapacity,
+                               const CBQAllocator_t* allocator);
 int CBQ_Clear(CBQueue_t* queue);
 int CBQ_QueueFree(CBQueue_t* queue);
 #ifdef CBQ_ALLOW_V2_METHODS
@@ -293,8 +388,64 @@ int CBQ_Skip(CBQueue_t* queue, size_t count, const int cutBySize, const int reve
 int CBQ_Push(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams, unsigned int stParamc, CBQArg_t stParams, ...);
 int CBQ_PushOnlyVP(CBQueue_t* queue, QCallback func, unsigned int varParamc, CBQArg_t* varParams);
 int CBQ_PushVoid(CBQueue_t* queue, QCallback func);
+
+/* Bulk push: capacity is increased once for all calls, calls are stored into free cells
+ * and published by one store index update. On error no call of batch is pushed.
+ */
+int CBQ_PushBatch(CBQueue_t* queue, const CBQCall_t* calls, size_t count);
+
+/* Zero-copy push: PushReserve prepares store cell for call with argc args and gives pointer
+ * to its args storage (NULL for void call), caller fills args in place and publishes call by PushCommit
+ * (or drops it by PushCancel). Until then other pushes, transfers into queue and capacity changes
+ * return CBQ_ERR_IS_BUSY and auto shrink is not done (args storage may be moved).
+ */
+int CBQ_PushReserve(CBQueue_t* queue, QCallback func, unsigned int argc, CBQArg_t** argsOut);
+int CBQ_PushCommit(CBQueue_t* queue);
+int CBQ_PushCancel(CBQueue_t* queue);
+
+/* Handle of the last pushed call (by any push method, for PushBatch of the last call of batch) */
+int CBQ_LastCallHandle(const CBQueue_t* queue, CBQHandle_t* handle);
+/* O(1) cancel of pushed call or timeout. Cancelled call stays in its cell as tombstone,
+ * exec methods skip it without call. Tombstones at the ends of queue are dropped by cancel,
+ * exec, skip and transfer, so size of queue includes only tombstones in the middle.
+ * Running call is not cancelled (CBQ_ERR_HANDLE_IS_STALE). With NO_EXCEPTIONS_OF_BUSY exec status
+ * is unknown, so call in read cell is never cancelled (CBQ_ERR_IS_BUSY).
+ * Cancelled timeout node is returned into free list of heap or wheel.
+ */
+int CBQ_Cancel(CBQHandle_t* handle);
 int CBQ_Exec(CBQueue_t* queue, int* funcRetSt);
+
+/* Batched exec: runs up to maxCount calls in one loop (busy status, auto shrink check and
+ * debug output are done once per batch). Calls pushed by callbacks are executed in the same batch,
+ * cancelled calls are passed and are not counted. ExecAll runs only calls which are in queue
+ * at the start, so self-pushing calls (SetTimeout) are left for next drain.
+ * retHook (may be NULL) gets return status of each callback.
+ */
+int CBQ_ExecBatch(CBQueue_t* queue, size_t maxCount, size_t* executedCount, CBQRetHook retHook, void* hookCtx);
+int CBQ_ExecAll(CBQueue_t* queue, size_t* executedCount, CBQRetHook retHook, void* hookCtx);
+
+/* Time-budgeted exec (frame/tick drivers): runs calls until queue is empty or budget (in ns of
+ * monotonic clock) is spent. Clock is read every CBQ_EXEC_FOR_CHECK_STEP calls, so last step
+ * may go over budget. remainCount (may be NULL) gets number of calls left in queue (without cancelled).
+ */
+int CBQ_ExecFor(CBQueue_t* queue, unsigned long long budgetNs, size_t* executedCount, size_t* remainCount, CBQRetHook retHook, void* hookCtx);
+
+/* Pushes call after delay (in clock ticks, CLOCKS_PER_SEC, or in seconds with isSec).
+ * Time is taken by CBQ_TIMER_METHODS (monotonic clock by default), so delay is wall time.
+ */
 int CBQ_SetTimeout(CBQueue_t* queue, clock_t delay, const int isSec, CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams);
+/* Same with delay in ns (rounded up to resolution of timer methods).
+ * handle (may be NULL) is set for CBQ_Cancel, it needs attached heap or wheel (see cbqtimer.h),
+ * because frame call of timeout is pushed again on each check (CBQ_ERR_TIMERS_NOT_ATTACHED otherwise).
+ */
+int CBQ_SetTimeoutNs(CBQueue_t* queue, unsigned long long delayNs, CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams,
+                     CBQHandle_t* handle);
+/* Pushes call every periodNs (first one after period), policy is one of CBQ_IntervalPolicies.
+ * With attached heap or wheel (see cbqtimer.h) args are kept by timer and are copied only into pushed call,
+ * otherwise frame call is re-pushed with args like in SetTimeout. handle is the same as in SetTimeoutNs.
+ */
+int CBQ_SetInterval(CBQueue_t* queue, unsigned long long periodNs, int policy, CBQueue_t* targetQueue, QCallback func, unsigned int vParamc, CBQArg_t* vParams,
+                    CBQHandle_t* handle);
 
 /* ---------------- Capacity changing methods declaration ---------------- */
 int CBQ_ChangeCapacity(CBQueue_t* queue, const int changeTowards, size_t customNewCapacity, const int adaptByLimits);
@@ -302,6 +453,16 @@ int CBQ_ChangeIncCapacityMode(CBQueue_t* queue, int newIncCapacityMode, size_t n
 int CBQ_EqualizeArgsCapByCustom(CBQueue_t* queue, unsigned int customCapacity, const int passNonModifiableArgs);
 int CBQ_ChangeInitArgsCapByCustom(CBQueue_t* queue, unsigned int customInitCapacity);
 
+/* Auto shrink policy: CBQ_Exec halves capacity (down to minCapacity) when size stays below
+ * lowWaterPercent of capacity for hysteresisExecs executions in a row and not earlier than
+ * minInterval (in clock ticks, CLOCKS_PER_SEC) after previous auto shrink.
+ * lowWaterPercent is in 1..CBQ_SHRINK_MAX_LOW_WATER range, 0 - turns policy off.
+ * Not used in CBQ_SM_STATIC capacity mode.
+ */
+#define CBQ_SHRINK_MAX_LOW_WATER 40
+
+int CBQ_SetAutoShrink(CBQueue_t* queue, unsigned int lowWaterPercent, unsigned int hysteresisExecs, clock_t minInterval, size_t minCapacity);
+
 /* ---------------- Additional methods declaration ---------------- */
 char* CBQ_strIntoHeap(const char* str);
 
@@ -27,6 +27,18 @@ int CBQ_GetVerIndex(void)
         #ifdef NO_FIX_ARGTYPES
         | 1 << (CBQ_VI_NFIXARGTYPES + BYTE_OFFSET)
         #endif // NO_FIX_ARGTYPES
+        #ifdef CBQ_POW2_CAPACITY
+        | 1 << (CBQ_VI_POW2CAPACITY + BYTE_OFFSET)
+        #endif // CBQ_POW2_CAPACITY
+        #ifdef CBQ_CHUNKED_STORAGE
+        | 1 << (CBQ_VI_CHUNKEDSTORAGE + BYTE_OFFSET)
+        #endif // CBQ_CHUNKED_STORAGE
+        #ifdef CBQ_ARGS_POOL
+        | 1 << (CBQ_VI_ARGSPOOL + BYTE_OFFSET)
+        #endif // CBQ_ARGS_POOL
+        #ifdef CBQ_LAZY_INIT
+        | 1 << (CBQ_VI_LAZYINIT + BYTE_OFFSET)
+        #endif // CBQ_LAZY_INIT
 
     #else // GEN_VERID
         (int) 0
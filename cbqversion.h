@@ -15,6 +15,10 @@ enum CBQ_VI {  // flags for checking VerId by CBQ_CheckVerIndexByFlag function
     CBQ_VI_REGCYCLEVARS,
     CBQ_VI_NRESTMEMFAIL,
     CBQ_VI_NFIXARGTYPES,
+    CBQ_VI_POW2CAPACITY,
+    CBQ_VI_CHUNKEDSTORAGE,
+    CBQ_VI_ARGSPOOL,
+    CBQ_VI_LAZYINIT,
 
     CBQ_VI_LAST_FLAG    // use it only when comparing with the return value from the CBQ_GetAvaliableFlagsRange function
 };
@@ -0,0 +1,110 @@
+#include <time.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif // __linux__
+#include "cbqbuildconf.h"
+#include "cbqwait.h"
+#include "cbqueue.h"
+#include "cbqlocal.h"
+
+#ifndef CBQ_ATOMIC_METHODS
+    #error Waiting exec needs atomic methods (see cbqlocal.h)
+#endif // CBQ_ATOMIC_METHODS
+
+#define NSEC_IN_SEC 1000000000L
+
+/* Sleeps while word is equal to expected value (spurious wakeups are possible) */
+static void CBQ_sleepOnWord__(int* word, int expected, const struct timespec* relTimeout)
+{
+    #if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, relTimeout, NULL, 0);
+    #else
+    /* no futex: short sleeps, so wakeup latency is up to 1 ms */
+    struct timespec nap = {0, 1000000L};
+
+    if (relTimeout != NULL && relTimeout->tv_sec == 0 && relTimeout->tv_nsec < nap.tv_nsec)
+        nap = *relTimeout;
+    if (CBQ_LOAD_ACQ(word) == expected)
+        nanosleep(&nap, NULL);
+    #endif // __linux__
+}
+
+static void CBQ_wakeWaiter__(CBQWaitState_t* waitState)
+{
+    CBQ_FETCH_ADD(&waitState->wakeSeq, 1);
+
+    #if defined(__linux__)
+    syscall(SYS_futex, &waitState->wakeSeq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    #endif // __linux__
+}
+
+/* Producers side, called after call is published */
+void CBQ_notifyWaiter__(CBQWaitState_t* waitState)
+{
+    /* pairs with fence of consumer: either consumer sees pushed call, or producer sees waiter */
+    CBQ_FENCE();
+    if (CBQ_LOAD_RLX(&waitState->waiters))
+        CBQ_wakeWaiter__(waitState);
+}
+
+int CBQ_execWait__(void* queue, CBQExecMethod__ exec, CBQWaitState_t* waitState, long timeout, int* funcRetSt)
+{
+    struct timespec now, deadline, remaining;
+    unsigned int spins;
+    int errSt, seq;
+
+    for (spins = 0; spins < CBQ_WAIT_SPIN_COUNT; spins++) {
+        errSt = exec(queue, funcRetSt);
+        if (errSt != CBQ_ERR_QUEUE_IS_EMPTY)
+            return errSt;
+        CBQ_CPU_RELAX();
+    }
+
+    if (!timeout)
+        return CBQ_ERR_QUEUE_IS_EMPTY;
+
+    if (timeout > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000000L;
+        if (deadline.tv_nsec >= NSEC_IN_SEC) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= NSEC_IN_SEC;
+        }
+    }
+
+    for (;;) {
+        seq = CBQ_LOAD_ACQ(&waitState->wakeSeq);
+
+        /* pairs with fence of producer */
+        CBQ_FETCH_ADD(&waitState->waiters, 1);
+        CBQ_FENCE();
+
+        errSt = exec(queue, funcRetSt);
+        if (errSt != CBQ_ERR_QUEUE_IS_EMPTY) {
+            CBQ_FETCH_SUB(&waitState->waiters, 1);
+            return errSt;
+        }
+
+        if (timeout > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += NSEC_IN_SEC;
+            }
+
+            if (remaining.tv_sec < 0) {
+                CBQ_FETCH_SUB(&waitState->waiters, 1);
+                return CBQ_ERR_QUEUE_IS_EMPTY;
+            }
+            CBQ_sleepOnWord__(&waitState->wakeSeq, seq, &remaining);
+        } else
+            CBQ_sleepOnWord__(&waitState->wakeSeq, seq, NULL);
+
+        CBQ_FETCH_SUB(&waitState->waiters, 1);
+    }
+}
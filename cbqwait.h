@@ -0,0 +1,37 @@
+#ifndef CBQWAIT_H
+#define CBQWAIT_H
+
+#include "cbqbuildconf.h"
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif // __cplusplus
+
+    /* Timeout of waiting exec methods (in ms): 0 - no sleep (spin only), CBQ_WAIT_INFINITE - until push */
+    #define CBQ_WAIT_INFINITE (-1L)
+
+    /* Number of exec attempts before consumer sleeps (may be set in cbqbuildconf.h) */
+    #ifndef CBQ_WAIT_SPIN_COUNT
+        #define CBQ_WAIT_SPIN_COUNT 100
+    #endif
+
+    /* Waiting consumers of concurrent queue. Consumer sleeps on wakeSeq (futex on Linux),
+     * producers change it and wake sleeper only if waiters counter is set,
+     * so push has no syscall while nobody sleeps.
+     */
+    typedef struct CBQWaitState_t CBQWaitState_t;
+    struct CBQWaitState_t {
+        int waiters;
+        int wakeSeq;
+    };
+
+typedef int (*CBQExecMethod__)(void*, int*);
+
+int CBQ_execWait__(void*, CBQExecMethod__, CBQWaitState_t*, long, int*);
+void CBQ_notifyWaiter__(CBQWaitState_t*);
+
+    #ifdef __cplusplus
+        }
+    #endif // __cplusplus
+
+#endif // CBQWAIT_H
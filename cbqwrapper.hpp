@@ -6,8 +6,11 @@
 #include "cbqueue.h"
 #include "cbqcallbacks.h"
 #include "cbqversion.h"
+#include "cbqexecutor.h"
+#include "cbqtimer.h"
 #include <exception>
 #include <string>
+#include <chrono>
 
 namespace CBQPP {
 
@@ -92,13 +95,22 @@ private:
     }
 }; // cbqcstr_exception class
 
+class Executor;
+class TimerWheel;
+class DeadlineHeap;
+
 /* Main class wrapper */
 class Queue {
 private:
     CBQueue_t cbq;
 
+    friend class Executor;
+    friend class TimerWheel;
+    friend class DeadlineHeap;
+
 public:
-    explicit Queue(size_t capacity = CBQ_SI_SMALL, CBQ_CapacityModes capacityMode = CBQ_SM_LIMIT, size_t maxCapacityLimit = CBQ_SI_BIG, unsigned int initArgsCapacity = 0);
+    explicit Queue(size_t capacity = CBQ_SI_SMALL, CBQ_CapacityModes capacityMode = CBQ_SM_LIMIT, size_t maxCapacityLimit = CBQ_SI_BIG, unsigned int initArgsCapacity = 0,
+                   const CBQAllocator_t* allocator = NULL);
     Queue(const Queue&);
     Queue(Queue&&) noexcept;
     Queue& operator=(const Queue&);
@@ -116,6 +128,16 @@ public:
     template <typename FuncT, typename... Args>
     int Push(FuncT func, Args... arguments) noexcept;
 
+    int PushBatch(const CBQCall_t* calls, size_t count) noexcept;
+    /* contiguous range of CBQCall_t (std::vector, std::array) */
+    template <typename RangeT>
+    int PushBatch(const RangeT& calls) noexcept;
+
+    /* zero-copy push (see CBQ_PushReserve) */
+    int PushReserve(QCallback func, unsigned int argc, CBQArg_t*& args) noexcept;
+    int PushCommit(void) noexcept;
+    int PushCancel(void) noexcept;
+
     template <typename... Args>
     int SetTimeout(QCallback func, clock_t delay, Args... arguments) noexcept;
     template <typename FuncT, typename... Args>
@@ -134,7 +156,37 @@ public:
     template <typename FuncT, typename... Args>
     int SetTimeoutForSec(Queue& target, FuncT func, clock_t delayInSec, Args... arguments) noexcept;
 
+    /* delay of any duration (ns resolution with monotonic timer methods) */
+    template <typename Rep, typename Period, typename... Args>
+    int SetTimeout(QCallback func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept;
+    template <typename FuncT, typename Rep, typename Period, typename... Args>
+    int SetTimeout(FuncT func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept;
+    template <typename Rep, typename Period, typename... Args>
+    int SetTimeout(Queue& target, QCallback func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept;
+    template <typename FuncT, typename Rep, typename Period, typename... Args>
+    int SetTimeout(Queue& target, FuncT func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept;
+
+    /* periodic call (see CBQ_SetInterval), missed periods are skipped by default */
+    template <typename Rep, typename Period, typename... Args>
+    int SetInterval(QCallback func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept;
+    template <typename FuncT, typename Rep, typename Period, typename... Args>
+    int SetInterval(FuncT func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept;
+    template <typename Rep, typename Period, typename... Args>
+    int SetInterval(Queue& target, CBQ_IntervalPolicies policy, QCallback func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept;
+    template <typename FuncT, typename Rep, typename Period, typename... Args>
+    int SetInterval(Queue& target, CBQ_IntervalPolicies policy, FuncT func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept;
+
     int Execute(int* cb_status = NULL) noexcept;
+    int ExecuteBatch(size_t maxCount, size_t* executedCount = NULL, CBQRetHook retHook = NULL, void* hookCtx = NULL) noexcept;
+    int ExecuteAll(size_t* executedCount = NULL, CBQRetHook retHook = NULL, void* hookCtx = NULL) noexcept;
+    int ExecuteFor(unsigned long long budgetNs, size_t* executedCount = NULL, size_t* remainCount = NULL, CBQRetHook retHook = NULL, void* hookCtx = NULL) noexcept;
+
+    /* time which event loop may sleep (see CBQ_NextDeadline) */
+    int NextDeadline(std::chrono::nanoseconds& wait) const noexcept;
+
+    /* handle of the last pushed call and cancel of call or timeout (see CBQ_Cancel) */
+    int LastCallHandle(CBQHandle_t& handle) const noexcept;
+    static int Cancel(CBQHandle_t& handle) noexcept;
 
     size_t Size(void) const noexcept;
     size_t Capacity(void) const noexcept;
@@ -153,6 +205,7 @@ public:
     int ChangeIncreaseCapacityMode(CBQ_CapacityModes newMode, size_t newLimit = CBQ_SI_MEDIUM, bool adaptLimit = true, bool tryToAdaptCapacity = true) noexcept;
     int EqualizeArgumentsCapacity(unsigned int requiredCapacity, bool skipNoneModifiable = true) noexcept;
     int ChangeInitArgumentsCapacity(unsigned int newCapacity) noexcept;
+    int SetAutoShrink(unsigned int lowWaterPercent, unsigned int hysteresisExecs = CBQ_SI_TINY, clock_t minInterval = CLOCKS_PER_SEC, size_t minCapacity = CBQ_SI_SMALL) noexcept;
 
     static int GetVerIndex(void);
     static bool CheckVerIndexByFlag(CBQ_VI fInfoType);
@@ -165,14 +218,15 @@ private:
     template <typename T> static T CBQ_convertToVal__(CBQArg_t arg) noexcept;
     template <typename FuncT, typename... ArgsT> static CBQArg_t CBQ_packCustomCB__(FuncT customCB) noexcept;
     template <typename... ArgsT> static int CBQ_invokeCustomCB__(int argc, CBQArg_t* argv) noexcept;
+    template <typename Rep, typename Period> static unsigned long long CBQ_durationToNs__(std::chrono::duration<Rep, Period> delay) noexcept;
 };
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Weffc++" // no need for members init list
 
-inline Queue::Queue(size_t capacity, CBQ_CapacityModes capacityMode, size_t maxCapacityLimit, unsigned int initArgsCapacity)
+inline Queue::Queue(size_t capacity, CBQ_CapacityModes capacityMode, size_t maxCapacityLimit, unsigned int initArgsCapacity, const CBQAllocator_t* allocator)
 {
-    int err = CBQ_QueueInit(&cbq, capacity, capacityMode, maxCapacityLimit, initArgsCapacity);
+    int err = CBQ_QueueInitWithAllocator(&cbq, capacity, capacityMode, maxCapacityLimit, initArgsCapacity, allocator);
     if (err)
         throw(cbqcstr_exception(err));
 }
@@ -292,6 +346,32 @@ inline int Queue::Push(QCallback func) noexcept
     return CBQ_PushVoid(&this->cbq, func);
 }
 
+inline int Queue::PushBatch(const CBQCall_t* calls, size_t count) noexcept
+{
+    return CBQ_PushBatch(&this->cbq, calls, count);
+}
+
+template <typename RangeT>
+inline int Queue::PushBatch(const RangeT& calls) noexcept
+{
+    return CBQ_PushBatch(&this->cbq, calls.data(), calls.size());
+}
+
+inline int Queue::PushReserve(QCallback func, unsigned int argc, CBQArg_t*& args) noexcept
+{
+    return CBQ_PushReserve(&this->cbq, func, argc, &args);
+}
+
+inline int Queue::PushCommit(void) noexcept
+{
+    return CBQ_PushCommit(&this->cbq);
+}
+
+inline int Queue::PushCancel(void) noexcept
+{
+    return CBQ_PushCancel(&this->cbq);
+}
+
 
 template <typename T> inline T Queue::CBQ_convertToVal__(CBQArg_t val) noexcept
 {
@@ -409,12 +489,110 @@ inline int Queue::SetTimeoutForSec(Queue& target, FuncT func, clock_t delayInSec
     return CBQ_SetTimeout(&this->cbq, delayInSec, 1, &target.cbq, CBQ_invokeCustomCB__<Args...>, sizeof...(arguments) + 1, sizeof...(arguments)? params : CBQ_NO_VPARAMS);
 }
 
+/* negative delay is pushed at once */
+template <typename Rep, typename Period>
+inline unsigned long long Queue::CBQ_durationToNs__(std::chrono::duration<Rep, Period> delay) noexcept
+{
+    const std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(delay);
+    return ns.count() > 0? static_cast<unsigned long long>(ns.count()) : 0ULL;
+}
+
+template <typename Rep, typename Period, typename... Args>
+inline int Queue::SetTimeout(QCallback func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept
+{
+    CBQArg_t params[] = {CBQ_convertToArg__<Args>(arguments)...};
+    return CBQ_SetTimeoutNs(&this->cbq, CBQ_durationToNs__(delay), &this->cbq, func, sizeof...(arguments), sizeof...(arguments)? params : CBQ_NO_VPARAMS, NULL);
+}
+
+template <typename FuncT, typename Rep, typename Period, typename... Args>
+inline int Queue::SetTimeout(FuncT func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept
+{
+    CBQArg_t params[] = { CBQ_packCustomCB__<FuncT, Args...>(func), CBQ_convertToArg__<Args>(arguments)... };
+    return CBQ_SetTimeoutNs(&this->cbq, CBQ_durationToNs__(delay), &this->cbq, CBQ_invokeCustomCB__<Args...>, sizeof...(arguments) + 1, params, NULL);
+}
+
+template <typename Rep, typename Period, typename... Args>
+inline int Queue::SetTimeout(Queue& target, QCallback func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept
+{
+    CBQArg_t params[] = {CBQ_convertToArg__<Args>(arguments)...};
+    return CBQ_SetTimeoutNs(&this->cbq, CBQ_durationToNs__(delay), &target.cbq, func, sizeof...(arguments), sizeof...(arguments)? params : CBQ_NO_VPARAMS, NULL);
+}
+
+template <typename FuncT, typename Rep, typename Period, typename... Args>
+inline int Queue::SetTimeout(Queue& target, FuncT func, std::chrono::duration<Rep, Period> delay, Args... arguments) noexcept
+{
+    CBQArg_t params[] = { CBQ_packCustomCB__<FuncT, Args...>(func), CBQ_convertToArg__<Args>(arguments)... };
+    return CBQ_SetTimeoutNs(&this->cbq, CBQ_durationToNs__(delay), &target.cbq, CBQ_invokeCustomCB__<Args...>, sizeof...(arguments) + 1, params, NULL);
+}
+
+template <typename Rep, typename Period, typename... Args>
+inline int Queue::SetInterval(QCallback func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept
+{
+    CBQArg_t params[] = {CBQ_convertToArg__<Args>(arguments)...};
+    return CBQ_SetInterval(&this->cbq, CBQ_durationToNs__(period), CBQ_IP_SKIP, &this->cbq, func, sizeof...(arguments), sizeof...(arguments)? params : CBQ_NO_VPARAMS, NULL);
+}
+
+template <typename FuncT, typename Rep, typename Period, typename... Args>
+inline int Queue::SetInterval(FuncT func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept
+{
+    CBQArg_t params[] = { CBQ_packCustomCB__<FuncT, Args...>(func), CBQ_convertToArg__<Args>(arguments)... };
+    return CBQ_SetInterval(&this->cbq, CBQ_durationToNs__(period), CBQ_IP_SKIP, &this->cbq, CBQ_invokeCustomCB__<Args...>, sizeof...(arguments) + 1, params, NULL);
+}
+
+template <typename Rep, typename Period, typename... Args>
+inline int Queue::SetInterval(Queue& target, CBQ_IntervalPolicies policy, QCallback func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept
+{
+    CBQArg_t params[] = {CBQ_convertToArg__<Args>(arguments)...};
+    return CBQ_SetInterval(&this->cbq, CBQ_durationToNs__(period), policy, &target.cbq, func, sizeof...(arguments), sizeof...(arguments)? params : CBQ_NO_VPARAMS, NULL);
+}
+
+template <typename FuncT, typename Rep, typename Period, typename... Args>
+inline int Queue::SetInterval(Queue& target, CBQ_IntervalPolicies policy, FuncT func, std::chrono::duration<Rep, Period> period, Args... arguments) noexcept
+{
+    CBQArg_t params[] = { CBQ_packCustomCB__<FuncT, Args...>(func), CBQ_convertToArg__<Args>(arguments)... };
+    return CBQ_SetInterval(&this->cbq, CBQ_durationToNs__(period), policy, &target.cbq, CBQ_invokeCustomCB__<Args...>, sizeof...(arguments) + 1, params, NULL);
+}
+
 
 inline int Queue::Execute(int* cb_status) noexcept
 {
     return CBQ_Exec(&this->cbq, cb_status);
 }
 
+inline int Queue::ExecuteBatch(size_t maxCount, size_t* executedCount, CBQRetHook retHook, void* hookCtx) noexcept
+{
+    return CBQ_ExecBatch(&this->cbq, maxCount, executedCount, retHook, hookCtx);
+}
+
+inline int Queue::ExecuteAll(size_t* executedCount, CBQRetHook retHook, void* hookCtx) noexcept
+{
+    return CBQ_ExecAll(&this->cbq, executedCount, retHook, hookCtx);
+}
+
+inline int Queue::ExecuteFor(unsigned long long budgetNs, size_t* executedCount, size_t* remainCount, CBQRetHook retHook, void* hookCtx) noexcept
+{
+    return CBQ_ExecFor(&this->cbq, budgetNs, executedCount, remainCount, retHook, hookCtx);
+}
+
+inline int Queue::NextDeadline(std::chrono::nanoseconds& wait) const noexcept
+{
+    unsigned long long waitNs = 0;
+    int err = CBQ_NextDeadline(&this->cbq, &waitNs);
+
+    wait = std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(waitNs));
+    return err;
+}
+
+inline int Queue::LastCallHandle(CBQHandle_t& handle) const noexcept
+{
+    return CBQ_LastCallHandle(&this->cbq, &handle);
+}
+
+inline int Queue::Cancel(CBQHandle_t& handle) noexcept
+{
+    return CBQ_Cancel(&handle);
+}
+
 inline size_t Queue::Size(void) const noexcept
 {
     size_t size;
@@ -486,6 +664,11 @@ inline int Queue::ChangeInitArgumentsCapacity(unsigned int newCapacity) noexcept
     return CBQ_ChangeInitArgsCapByCustom(&this->cbq, newCapacity);
 }
 
+inline int Queue::SetAutoShrink(unsigned int lowWaterPercent, unsigned int hysteresisExecs, clock_t minInterval, size_t minCapacity) noexcept
+{
+    return CBQ_SetAutoShrink(&this->cbq, lowWaterPercent, hysteresisExecs, minInterval, minCapacity);
+}
+
 
 inline int Queue::GetVerIndex(void)
 {
@@ -512,4 +695,199 @@ inline bool Queue::IsCustomisedVersion(void)
     return CBQ_IsCustomisedVersion();
 }
 
+
+/* Thread-pool executor wrapper, workers are stopped with drain on destruction */
+class Executor {
+private:
+    CBQExecutor_t cbe;
+
+public:
+    explicit Executor(unsigned int threadsCount, unsigned int spinCount = 1000, unsigned int parkTimeout = 0,
+                      CBQErrHook errHook = NULL, void* hookCtx = NULL);
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    ~Executor() noexcept;
+
+    int AddQueue(Queue& queue) noexcept;
+    int AddQueue(CBQSpscQueue_t& queue) noexcept;
+    int AddQueue(CBQMpscQueue_t& queue) noexcept;
+    int AddQueue(CBQMpmcQueue_t& queue) noexcept;
+
+    int Start(void) noexcept;
+    int Notify(void) noexcept;
+    int Stop(bool drain = true) noexcept;
+};
+
+inline Executor::Executor(unsigned int threadsCount, unsigned int spinCount, unsigned int parkTimeout, CBQErrHook errHook, void* hookCtx)
+:
+    cbe()
+{
+    int err = CBQ_ExecutorInit(&cbe, threadsCount, spinCount, parkTimeout, errHook, hookCtx);
+    if (err)
+        throw(cbqcstr_exception(err));
+}
+
+inline Executor::~Executor() noexcept
+{
+    CBQ_ExecutorStop(&this->cbe, 1);
+    CBQ_ExecutorFree(&this->cbe);
+}
+
+inline int Executor::AddQueue(Queue& queue) noexcept
+{
+    return CBQ_ExecutorAddQueue(&this->cbe, CBQ_EXQ_QUEUE, &queue.cbq);
+}
+
+inline int Executor::AddQueue(CBQSpscQueue_t& queue) noexcept
+{
+    return CBQ_ExecutorAddQueue(&this->cbe, CBQ_EXQ_SPSC, &queue);
+}
+
+inline int Executor::AddQueue(CBQMpscQueue_t& queue) noexcept
+{
+    return CBQ_ExecutorAddQueue(&this->cbe, CBQ_EXQ_MPSC, &queue);
+}
+
+inline int Executor::AddQueue(CBQMpmcQueue_t& queue) noexcept
+{
+    return CBQ_ExecutorAddQueue(&this->cbe, CBQ_EXQ_MPMC, &queue);
+}
+
+inline int Executor::Start(void) noexcept
+{
+    return CBQ_ExecutorStart(&this->cbe);
+}
+
+inline int Executor::Notify(void) noexcept
+{
+    return CBQ_ExecutorNotify(&this->cbe);
+}
+
+inline int Executor::Stop(bool drain) noexcept
+{
+    return CBQ_ExecutorStop(&this->cbe, static_cast<int>(drain));
+}
+
+
+/* Timer wheel wrapper, wheel must be detached from queues before destruction */
+class TimerWheel {
+private:
+    CBQTimerWheel_t cbw;
+
+public:
+    explicit TimerWheel(std::chrono::nanoseconds tick = std::chrono::milliseconds(1), const CBQAllocator_t* allocator = NULL);
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    ~TimerWheel() noexcept;
+
+    int Attach(Queue& queue) noexcept;
+    int Detach(Queue& queue) noexcept;
+
+    int Advance(size_t* movedCount = NULL) noexcept;
+    int Cancel(CBQTimerHandle_t& handle) noexcept;
+    size_t GetCount(void) const noexcept;
+};
+
+inline TimerWheel::TimerWheel(std::chrono::nanoseconds tick, const CBQAllocator_t* allocator)
+:
+    cbw()
+{
+    int err = CBQ_TimerWheelInit(&cbw, static_cast<unsigned long long>(tick.count()), allocator);
+    if (err)
+        throw(cbqcstr_exception(err));
+}
+
+inline TimerWheel::~TimerWheel() noexcept
+{
+    CBQ_TimerWheelFree(&this->cbw);
+}
+
+inline int TimerWheel::Attach(Queue& queue) noexcept
+{
+    return CBQ_QueueAttachTimers(&queue.cbq, &this->cbw);
+}
+
+inline int TimerWheel::Detach(Queue& queue) noexcept
+{
+    return CBQ_QueueAttachTimers(&queue.cbq, NULL);
+}
+
+inline int TimerWheel::Advance(size_t* movedCount) noexcept
+{
+    return CBQ_TimerWheelAdvance(&this->cbw, movedCount);
+}
+
+inline int TimerWheel::Cancel(CBQTimerHandle_t& handle) noexcept
+{
+    return CBQ_TimerCancel(&this->cbw, &handle);
+}
+
+inline size_t TimerWheel::GetCount(void) const noexcept
+{
+    size_t count = 0;
+    CBQ_TimerWheelGetCount(&this->cbw, &count);
+    return count;
+}
+
+
+/* Deadline heap wrapper, heap must be detached from queues before destruction */
+class DeadlineHeap {
+private:
+    CBQDeadlineHeap_t cbh;
+
+public:
+    explicit DeadlineHeap(size_t initCapacity = 0, const CBQAllocator_t* allocator = NULL);
+    DeadlineHeap(const DeadlineHeap&) = delete;
+    DeadlineHeap& operator=(const DeadlineHeap&) = delete;
+    ~DeadlineHeap() noexcept;
+
+    int Attach(Queue& queue) noexcept;
+    int Detach(Queue& queue) noexcept;
+
+    int Advance(size_t* movedCount = NULL) noexcept;
+    int Cancel(CBQTimerHandle_t& handle) noexcept;
+    size_t GetCount(void) const noexcept;
+};
+
+inline DeadlineHeap::DeadlineHeap(size_t initCapacity, const CBQAllocator_t* allocator)
+:
+    cbh()
+{
+    int err = CBQ_DeadlineHeapInit(&cbh, initCapacity, allocator);
+    if (err)
+        throw(cbqcstr_exception(err));
+}
+
+inline DeadlineHeap::~DeadlineHeap() noexcept
+{
+    CBQ_DeadlineHeapFree(&this->cbh);
+}
+
+inline int DeadlineHeap::Attach(Queue& queue) noexcept
+{
+    return CBQ_QueueAttachDeadlines(&queue.cbq, &this->cbh);
+}
+
+inline int DeadlineHeap::Detach(Queue& queue) noexcept
+{
+    return CBQ_QueueAttachDeadlines(&queue.cbq, NULL);
+}
+
+inline int DeadlineHeap::Advance(size_t* movedCount) noexcept
+{
+    return CBQ_DeadlineHeapAdvance(&this->cbh, movedCount);
+}
+
+inline int DeadlineHeap::Cancel(CBQTimerHandle_t& handle) noexcept
+{
+    return CBQ_DeadlineCancel(&this->cbh, &handle);
+}
+
+inline size_t DeadlineHeap::GetCount(void) const noexcept
+{
+    size_t count = 0;
+    CBQ_DeadlineHeapGetCount(&this->cbh, &count);
+    return count;
+}
+
 }   // CBQPP namespace
@@ -17,6 +17,25 @@
         // CBQ_T_TransferTest();
         // CBQ_T_SkipTest();
         // CBQ_T_VerIdInfo(2);
+        // CBQ_T_RecordsTest();
+        // CBQ_T_AllocatorTest();
+        // CBQ_T_ArgsPoolTest();
+        // CBQ_T_AutoShrinkTest();
+        // CBQ_T_SpscTest();
+        // CBQ_T_MpscTest();
+        // CBQ_T_MpmcTest();
+        // CBQ_T_ExecutorTest();
+        // CBQ_T_SchedulerTest();
+        // CBQ_T_ExecWaitTest();
+        // CBQ_T_ExecBatchTest();
+        // CBQ_T_ExecForTest();
+        // CBQ_T_PushBatchTest();
+        // CBQ_T_PushReserveTest();
+        // CBQ_T_TimerWheelTest();
+        // CBQ_T_SetTimeoutNsTest();
+        // CBQ_T_DeadlineHeapTest();
+        // CBQ_T_SetIntervalTest();
+        // CBQ_T_CancelTest();
 
         return 0;
     }